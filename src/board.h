@@ -11,8 +11,10 @@
 #define ACCEL_INT1 7
 #define ACCEL_INT2 8
 #define LED_PIN 14
+#define MIC_PIN 26
 #define NUM_LEDS 12
 
 // Accelerometer
 #define ACCEL_I2C_INSTANCE i2c0
 #define ACCEL_I2C_ADDRESS 0b0011001 // last bit is the read/write bit
+#define ACCEL_SPI_INSTANCE spi0 // SCLK, MOSI and MISO are on the SPI0 pins
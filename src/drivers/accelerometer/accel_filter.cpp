@@ -0,0 +1,151 @@
+#include "accel_filter.h"
+#include <math.h>
+
+#define ACCEL_FILTER_UNITY (1 << (15 - ACCEL_FILTER_POST_SHIFT)) // A coefficient of 1 once quantised
+
+// The three axes of a sample, so each can be gathered into a block of its own
+static int16_t accel_sample::*const axis_fields[3] = {&accel_sample::x, &accel_sample::y, &accel_sample::z};
+
+accel_filter::accel_filter()
+    : type(accel_filter_type::none), stages(0), primed(false), coefficients(), state(), instances(), block()
+{
+}
+
+bool accel_filter::configure(accel_filter_type type, float sample_rate_hz, float cutoff_hz)
+{
+    if (type != accel_filter_type::none &&
+        (cutoff_hz <= 0 || cutoff_hz * 2 >= sample_rate_hz || cutoff_hz * ACCEL_FILTER_MIN_CUTOFF_RATIO < sample_rate_hz))
+    {
+        return false;
+    }
+
+    const double pi = 3.14159265358979323846;
+    double w0 = 2 * pi * cutoff_hz / sample_rate_hz;
+    switch (type)
+    {
+    case accel_filter_type::none:
+        stages = 0;
+        break;
+    case accel_filter_type::low_pass:
+    case accel_filter_type::high_pass:
+        // A 4th order Butterworth is two sections whose poles sit at 22.5 and 67.5 degrees from the real axis
+        stages = 2;
+        design_section(0, type == accel_filter_type::high_pass, w0, 1 / (2 * cos(pi / 8)));
+        design_section(1, type == accel_filter_type::high_pass, w0, 1 / (2 * cos(3 * pi / 8)));
+        break;
+    case accel_filter_type::gravity_removal:
+    {
+        // y[n] = g * (x[n] - x[n-1]) + r * y[n-1], with unity gain at Nyquist
+        double r = exp(-w0);
+        q15_t *c = coefficients;
+        c[0] = to_q15((1 + r) / 2);
+        c[1] = 0;
+        c[2] = (q15_t)-c[0];
+        c[3] = 0;
+        c[4] = to_q15(r);
+        c[5] = 0;
+        stages = 1;
+        break;
+    }
+    }
+    this->type = type;
+    reset();
+    return true;
+}
+
+void accel_filter::reset()
+{
+    for (int axis = 0; axis < 3 && stages > 0; axis++)
+    {
+        arm_biquad_cascade_df1_init_q15(&instances[axis], (uint8_t)stages, coefficients, state[axis],
+                                        ACCEL_FILTER_POST_SHIFT);
+    }
+    primed = false;
+}
+
+void accel_filter::process(accel_sample samples[], int count)
+{
+    if (stages == 0)
+    {
+        return;
+    }
+    for (int start = 0; start < count; start += ACCEL_FIFO_DEPTH)
+    {
+        int length = (count - start < ACCEL_FIFO_DEPTH) ? count - start : ACCEL_FIFO_DEPTH;
+        accel_sample *chunk = &samples[start];
+        for (int axis = 0; axis < 3; axis++)
+        {
+            int16_t accel_sample::*field = axis_fields[axis];
+            for (int i = 0; i < length; i++)
+            {
+                block[i] = (q15_t)(chunk[i].*field >> ACCEL_FILTER_HEADROOM_BITS);
+            }
+            if (!primed)
+            {
+                prime(axis, block[0]);
+            }
+            arm_biquad_cascade_df1_q15(&instances[axis], block, block, (uint32_t)length);
+            for (int i = 0; i < length; i++)
+            {
+                // Back up to the raw scale, saturating anything the filter pushed past full scale
+                int32_t value = (int32_t)block[i] * (1 << ACCEL_FILTER_HEADROOM_BITS);
+                chunk[i].*field = (int16_t)(value > INT16_MAX ? INT16_MAX : (value < INT16_MIN ? INT16_MIN : value));
+            }
+        }
+        primed = true;
+    }
+}
+
+accel_filter_type accel_filter::get_type() const
+{
+    return type;
+}
+
+q15_t accel_filter::to_q15(double coefficient)
+{
+    double scaled = coefficient * ACCEL_FILTER_UNITY;
+    long rounded = lround(scaled);
+    return (q15_t)(rounded > INT16_MAX ? INT16_MAX : (rounded < INT16_MIN ? INT16_MIN : rounded));
+}
+
+// Bilinear transform Butterworth section, from the Audio EQ Cookbook. CMSIS-DSP adds the feedback terms, so a1 and
+// a2 are stored negated.
+void accel_filter::design_section(int stage, bool high_pass, double w0, double q)
+{
+    double cos_w0 = cos(w0);
+    double alpha = sin(w0) / (2 * q);
+    double a0 = 1 + alpha;
+    q15_t *c = &coefficients[stage * 6];
+    c[1] = 0;
+    c[4] = to_q15(2 * cos_w0 / a0);
+    c[5] = to_q15(-(1 - alpha) / a0);
+    if (high_pass)
+    {
+        c[0] = to_q15((1 + cos_w0) / 2 / a0);
+        c[2] = (q15_t)(-2 * c[0]); // Zeros exactly at DC, whatever the rounding
+        c[3] = c[0];
+    }
+    else
+    {
+        // Share out the quantised 1 - a1 - a2 between the b coefficients, so the DC gain is exactly 1
+        int32_t dc = ACCEL_FILTER_UNITY - c[4] - c[5];
+        c[0] = (q15_t)((dc + 2) / 4);
+        c[2] = (q15_t)(dc - 2 * c[0]);
+        c[3] = c[0];
+    }
+}
+
+void accel_filter::prime(int axis, q15_t value)
+{
+    // A low pass passes a steady reading through unchanged; the high passes settle to 0
+    q15_t output = (type == accel_filter_type::low_pass) ? value : 0;
+    for (int stage = 0; stage < stages; stage++)
+    {
+        q15_t input = (stage == 0 || type == accel_filter_type::low_pass) ? value : 0;
+        q15_t *s = &state[axis][stage * 4];
+        s[0] = input;
+        s[1] = input;
+        s[2] = output;
+        s[3] = output;
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef ACCEL_FILTER_H
+#define ACCEL_FILTER_H
+
+#include <stdint.h>
+#include "accelerometer.h"
+#include "arm_math.h"
+
+#define ACCEL_FILTER_MAX_STAGES 2          // Biquads in the longest cascade, a 4th order Butterworth
+#define ACCEL_FILTER_POST_SHIFT 1          // Coefficients are stored halved, so they can reach ±2
+#define ACCEL_FILTER_HEADROOM_BITS 2       // Samples are filtered this many bits down, leaving room for overshoot
+#define ACCEL_FILTER_MIN_CUTOFF_RATIO 200  // The cutoff must be at least the sample rate over this
+
+/*! \brief Response of an `accel_filter`. */
+enum class accel_filter_type {
+    none,            /*!< Samples pass through unchanged */
+    low_pass,        /*!< 4th order Butterworth, smoothing out noise and vibration above the cutoff */
+    high_pass,       /*!< 4th order Butterworth, keeping only movement above the cutoff */
+    gravity_removal, /*!< 1st order DC blocker, taking out the steady 1 g of gravity but little else */
+};
+
+/*! \brief Filters blocks of accelerometer samples, such as a FIFO batch, with a Q15 biquad cascade per axis.
+ *
+ * The cascades run with CMSIS-DSP's `arm_biquad_cascade_df1_q15`, once per axis per block, so the per-call cost is
+ * paid once per batch rather than once per sample. Coefficients are designed in floating point by `configure()` and
+ * then quantised; the low-pass sections are quantised so that their DC gain stays exactly 1.
+ *
+ * The sensor's 12 significant bits are left justified, so samples are shifted down by `ACCEL_FILTER_HEADROOM_BITS`
+ * without losing anything and the filter can overshoot a full scale step without clipping. Cutoffs below
+ * 1/`ACCEL_FILTER_MIN_CUTOFF_RATIO` of the sample rate are refused, as the Q15 coefficients become too coarse.
+ */
+class accel_filter
+{
+public:
+    accel_filter();
+
+    /*! \brief Designs the filter and resets it.
+     *
+     * \param type The response.
+     * \param sample_rate_hz The rate of the samples that will be filtered.
+     * \param cutoff_hz The -3 dB frequency. Ignored for `accel_filter_type::none`.
+     * \return false, leaving the filter as it was, if the cutoff is out of range for the sample rate.
+     */
+    bool configure(accel_filter_type type, float sample_rate_hz, float cutoff_hz);
+
+    /*! \brief Forgets the samples seen so far. The next block primes the filter with its first sample, as if that
+     * reading had been steady for ever, so there is no start-up transient.
+     */
+    void reset();
+
+    /*! \brief Filters `count` samples in place, carrying on from the previous block. Timestamps are unchanged. */
+    void process(accel_sample samples[], int count);
+
+    /*! \brief Returns the configured response. */
+    accel_filter_type get_type() const;
+
+private:
+    /*! \brief Quantises a coefficient to Q15, halved by the post shift. */
+    static q15_t to_q15(double coefficient);
+
+    /*! \brief Sets the coefficients of one Butterworth section with quality factor `q`. */
+    void design_section(int stage, bool high_pass, double w0, double q);
+
+    /*! \brief Fills the state of one axis as if `value` had been its input for ever. */
+    void prime(int axis, q15_t value);
+
+    accel_filter_type type;
+    int stages;
+    bool primed;
+    q15_t coefficients[ACCEL_FILTER_MAX_STAGES * 6]; // {b0, 0, b1, b2, a1, a2} per stage, as CMSIS-DSP lays them out
+    q15_t state[3][ACCEL_FILTER_MAX_STAGES * 4];     // {x[n-1], x[n-2], y[n-1], y[n-2]} per stage, per axis
+    arm_biquad_casd_df1_inst_q15 instances[3];
+    q15_t block[ACCEL_FIFO_DEPTH];                   // One axis of the block being filtered
+};
+
+#endif // ACCEL_FILTER_H
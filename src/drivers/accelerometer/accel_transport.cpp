@@ -0,0 +1,203 @@
+#include "accel_transport.h"
+#include "hardware/gpio.h"
+#include "hardware/dma.h"
+
+accel_i2c_transport::accel_i2c_transport(i2c_inst_t *i2c, uint sda_pin, uint scl_pin, uint8_t address, uint baudrate)
+    : bus(i2c_dma::for_instance(i2c)), sda(sda_pin), scl(scl_pin), address(address), baudrate(baudrate), transfers(),
+      queued(0)
+{
+}
+
+void accel_i2c_transport::init()
+{
+    // The engine sets up the I2C block and its pins, once for every device on the bus
+    bus.init(sda, scl, baudrate);
+}
+
+bool accel_i2c_transport::read(uint8_t reg, uint8_t *data, size_t length)
+{
+    uint8_t start_register = (length > 1) ? (reg | AUTO_INCREMENT) : reg;
+    return bus.transfer_blocking(address, &start_register, 1, data, length); // Register address, then a repeated start
+}
+
+bool accel_i2c_transport::write(uint8_t reg, const uint8_t *data, size_t length)
+{
+    if (length >= I2C_DMA_MAX_WRITE)
+    {
+        return false;
+    }
+    uint8_t buf[I2C_DMA_MAX_WRITE];
+    buf[0] = (length > 1) ? (reg | AUTO_INCREMENT) : reg;
+    for (size_t i = 0; i < length; i++)
+    {
+        buf[i + 1] = data[i];
+    }
+    return bus.transfer_blocking(address, buf, length + 1, nullptr, 0);
+}
+
+bool accel_i2c_transport::queue_read(uint8_t reg, uint8_t *data, size_t length)
+{
+    if (queued >= ACCEL_TRANSPORT_MAX_QUEUED)
+    {
+        return false;
+    }
+    uint8_t start_register = (length > 1) ? (reg | AUTO_INCREMENT) : reg;
+    if (!bus.submit(transfers[queued], address, &start_register, 1, data, length))
+    {
+        return false;
+    }
+    queued++;
+    return true;
+}
+
+bool accel_i2c_transport::is_queue_done()
+{
+    for (int i = 0; i < queued; i++)
+    {
+        if (!transfers[i].is_finished())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool accel_i2c_transport::finish_queue()
+{
+    while (!is_queue_done())
+    {
+        tight_loop_contents();
+    }
+    bool succeeded = true;
+    for (int i = 0; i < queued; i++)
+    {
+        succeeded = succeeded && (transfers[i].status == i2c_transfer_status::done);
+    }
+    queued = 0;
+    return succeeded;
+}
+
+accel_spi_transport::accel_spi_transport(spi_inst_t *spi, uint sclk_pin, uint mosi_pin, uint miso_pin, uint cs_pin,
+                                         uint baudrate)
+    : spi(spi), sclk(sclk_pin), mosi(mosi_pin), miso(miso_pin), cs(cs_pin), baudrate(baudrate), tx_channel(-1),
+      rx_channel(-1), reads(), queued(0), started(0), reading(false)
+{
+}
+
+void accel_spi_transport::init()
+{
+    // The LIS3DH samples MOSI on the rising edge with the clock idling high: SPI mode 3
+    spi_init(spi, baudrate);
+    spi_set_format(spi, 8, SPI_CPOL_1, SPI_CPHA_1, SPI_MSB_FIRST);
+    gpio_set_function(sclk, GPIO_FUNC_SPI);
+    gpio_set_function(mosi, GPIO_FUNC_SPI);
+    gpio_set_function(miso, GPIO_FUNC_SPI);
+
+    // Chip select high before it becomes an output, so the sensor never sees a spurious access (and stays off I2C)
+    gpio_init(cs);
+    gpio_put(cs, 1);
+    gpio_set_dir(cs, GPIO_OUT);
+
+    if (tx_channel < 0)
+    {
+        tx_channel = dma_claim_unused_channel(true);
+        rx_channel = dma_claim_unused_channel(true);
+    }
+}
+
+uint8_t accel_spi_transport::command(uint8_t reg, bool read, size_t length)
+{
+    return (reg & 0x3F) | (read ? READ : 0) | ((length > 1) ? AUTO_INCREMENT : 0);
+}
+
+bool accel_spi_transport::read(uint8_t reg, uint8_t *data, size_t length)
+{
+    finish_queue(); // The bus is not shared with a queued burst
+    uint8_t start = command(reg, true, length);
+    gpio_put(cs, 0);
+    spi_write_blocking(spi, &start, 1);
+    spi_read_blocking(spi, 0, data, length);
+    gpio_put(cs, 1);
+    return true; // Without an acknowledge, SPI cannot tell whether anything answered
+}
+
+bool accel_spi_transport::write(uint8_t reg, const uint8_t *data, size_t length)
+{
+    finish_queue();
+    uint8_t start = command(reg, false, length);
+    gpio_put(cs, 0);
+    spi_write_blocking(spi, &start, 1);
+    spi_write_blocking(spi, data, length);
+    gpio_put(cs, 1);
+    return true;
+}
+
+bool accel_spi_transport::queue_read(uint8_t reg, uint8_t *data, size_t length)
+{
+    if (queued >= ACCEL_TRANSPORT_MAX_QUEUED || tx_channel < 0)
+    {
+        return false;
+    }
+    reads[queued++] = {reg, data, length};
+    if (!reading)
+    {
+        is_queue_done(); // Puts it on the bus straight away if nothing is ahead of it
+    }
+    return true;
+}
+
+// Send the command byte, then clock the burst in with a pair of DMA channels: TX repeats a dummy byte to drive the
+// clock while RX collects the data
+void accel_spi_transport::start_read(const pending_read &read)
+{
+    static const uint8_t dummy = 0;
+    uint8_t start = command(read.reg, true, read.length);
+    gpio_put(cs, 0);
+    spi_write_blocking(spi, &start, 1); // Also leaves the RX FIFO empty
+
+    dma_channel_config rx_config = dma_channel_get_default_config(rx_channel);
+    channel_config_set_transfer_data_size(&rx_config, DMA_SIZE_8);
+    channel_config_set_read_increment(&rx_config, false);
+    channel_config_set_write_increment(&rx_config, true);
+    channel_config_set_dreq(&rx_config, spi_get_dreq(spi, false));
+    dma_channel_configure(rx_channel, &rx_config, read.data, &spi_get_hw(spi)->dr, read.length, true);
+
+    dma_channel_config tx_config = dma_channel_get_default_config(tx_channel);
+    channel_config_set_transfer_data_size(&tx_config, DMA_SIZE_8);
+    channel_config_set_read_increment(&tx_config, false);
+    channel_config_set_write_increment(&tx_config, false);
+    channel_config_set_dreq(&tx_config, spi_get_dreq(spi, true));
+    dma_channel_configure(tx_channel, &tx_config, &spi_get_hw(spi)->dr, &dummy, read.length, true);
+    reading = true;
+}
+
+// Queued reads only move on when polled: each finished burst releases the chip select and starts the next
+bool accel_spi_transport::is_queue_done()
+{
+    if (reading)
+    {
+        if (dma_channel_is_busy(rx_channel))
+        {
+            return false;
+        }
+        gpio_put(cs, 1); // RX finishes last, once the final byte has been clocked in
+        reading = false;
+    }
+    if (started < queued)
+    {
+        start_read(reads[started++]);
+        return false;
+    }
+    return true;
+}
+
+bool accel_spi_transport::finish_queue()
+{
+    while (!is_queue_done())
+    {
+        tight_loop_contents();
+    }
+    queued = 0;
+    started = 0;
+    return true;
+}
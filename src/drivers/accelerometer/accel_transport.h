@@ -0,0 +1,133 @@
+#ifndef ACCEL_TRANSPORT_H
+#define ACCEL_TRANSPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "hardware/spi.h"
+#include "drivers/i2c/i2c_dma.h"
+
+#define ACCEL_TRANSPORT_MAX_QUEUED 2        // Background reads that can be queued at once
+#define ACCEL_I2C_BAUDRATE (400 * 1000)     // Fast mode, the fastest the LIS3DH supports over I2C
+#define ACCEL_SPI_BAUDRATE (10 * 1000 * 1000) // The fastest the LIS3DH supports over SPI
+
+/*! \brief Register access to an LIS3DH, over whichever bus it is wired to.
+ *
+ * Reads and writes of more than one register use the sensor's auto-increment, so a block of registers (or the FIFO)
+ * moves in one burst. Reads can also be queued to run in the background while the caller does other work.
+ */
+class accel_transport
+{
+public:
+    virtual ~accel_transport() = default;
+
+    /*! \brief Sets up the bus and its pins. */
+    virtual void init() = 0;
+
+    /*! \brief Reads `length` consecutive registers starting at `reg`, waiting for the data.
+     *
+     * \return false if the sensor did not respond.
+     */
+    virtual bool read(uint8_t reg, uint8_t *data, size_t length) = 0;
+
+    /*! \brief Writes `length` consecutive registers starting at `reg`, at most 7.
+     *
+     * \return false if the sensor did not respond.
+     */
+    virtual bool write(uint8_t reg, const uint8_t *data, size_t length) = 0;
+
+    /*! \brief Queues a read of `length` consecutive registers starting at `reg` and returns straight away.
+     *
+     * Up to `ACCEL_TRANSPORT_MAX_QUEUED` reads can be queued. They run in order, and `data` must stay valid until
+     * `finish_queue()` returns.
+     *
+     * \return false if the queue is full or the read could not be started.
+     */
+    virtual bool queue_read(uint8_t reg, uint8_t *data, size_t length) = 0;
+
+    /*! \brief Returns true once every queued read has finished, or if none are queued. */
+    virtual bool is_queue_done() = 0;
+
+    /*! \brief Waits for the queued reads and empties the queue.
+     *
+     * \return true if every queued read succeeded.
+     */
+    virtual bool finish_queue() = 0;
+};
+
+/*! \brief LIS3DH access over I2C, with transfers run in the background by the bus's `i2c_dma` engine. */
+class accel_i2c_transport : public accel_transport
+{
+public:
+    accel_i2c_transport(i2c_inst_t *i2c, uint sda_pin, uint scl_pin, uint8_t address,
+                        uint baudrate = ACCEL_I2C_BAUDRATE);
+
+    void init() override;
+    bool read(uint8_t reg, uint8_t *data, size_t length) override;
+    bool write(uint8_t reg, const uint8_t *data, size_t length) override;
+    bool queue_read(uint8_t reg, uint8_t *data, size_t length) override;
+    bool is_queue_done() override;
+    bool finish_queue() override;
+
+private:
+    static constexpr uint8_t AUTO_INCREMENT = 0x80; // Set in the register address to move through several registers
+
+    i2c_dma &bus;
+    uint sda;
+    uint scl;
+    uint8_t address;
+    uint baudrate;
+    i2c_transfer transfers[ACCEL_TRANSPORT_MAX_QUEUED];
+    int queued;
+};
+
+/*! \brief LIS3DH access over SPI at up to 10 MHz, 25 times faster than I2C.
+ *
+ * Blocking accesses use the SDK functions. Queued reads send the register address and then hand the burst to two DMA
+ * channels; they are moved on by `is_queue_done()` and `finish_queue()`, so no interrupt is needed. The chip select
+ * is driven as a GPIO so that it stays low for the whole burst.
+ */
+class accel_spi_transport : public accel_transport
+{
+public:
+    accel_spi_transport(spi_inst_t *spi, uint sclk_pin, uint mosi_pin, uint miso_pin, uint cs_pin,
+                        uint baudrate = ACCEL_SPI_BAUDRATE);
+
+    void init() override;
+    bool read(uint8_t reg, uint8_t *data, size_t length) override;
+    bool write(uint8_t reg, const uint8_t *data, size_t length) override;
+    bool queue_read(uint8_t reg, uint8_t *data, size_t length) override;
+    bool is_queue_done() override;
+    bool finish_queue() override;
+
+private:
+    struct pending_read {
+        uint8_t reg;
+        uint8_t *data;
+        size_t length;
+    };
+
+    /*! \brief Returns the command byte that starts an access: read/write in bit 7, auto-increment in bit 6. */
+    static uint8_t command(uint8_t reg, bool read, size_t length);
+
+    void start_read(const pending_read &read);
+
+    static constexpr uint8_t READ = 0x80;
+    static constexpr uint8_t AUTO_INCREMENT = 0x40;
+
+    spi_inst_t *spi;
+    uint sclk;
+    uint mosi;
+    uint miso;
+    uint cs;
+    uint baudrate;
+    int tx_channel;
+    int rx_channel;
+    pending_read reads[ACCEL_TRANSPORT_MAX_QUEUED];
+    int queued;     // Reads in the queue
+    int started;    // Reads put on the bus so far
+    bool reading;   // A read is on the bus, with the chip selected
+};
+
+#endif // ACCEL_TRANSPORT_H
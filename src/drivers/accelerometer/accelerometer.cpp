@@ -1,26 +1,26 @@
 #include "accelerometer.h"
 #include <stdio.h>
 #include "board.h"
-#include "hardware/i2c.h"
 #include "hardware/gpio.h"
+#include "hardware/sync.h"
+
+Accelerometer *Accelerometer::fifo_owner = nullptr;
 
 // Constructor
-Accelerometer::Accelerometer(i2c_inst_t *i2c_instance, uint8_t sda_pin, uint8_t scl_pin, uint8_t address)
-    : i2c(i2c_instance), sda(sda_pin), scl(scl_pin), address(address)
+Accelerometer::Accelerometer(accel_transport &transport)
+    : transport(transport), ctrl(), ctrl_dirty(0), data_rate_hz(0), scale_g(0), resolution(accel_resolution::normal),
+      raw_span_mg(0), int1_pin(0), fifo_running(false), sample_period_us(0), watermark(0), watermark_time_us(0),
+      batch_pending(false), fifo_overruns(0), next_sample_time_us(0), fifo_raw(), fifo_read_source(0),
+      fifo_read_samples(nullptr), fifo_read_count(0), fifo_read_in_progress(false), fifo_read_queued(false),
+      fifo_read_fresh_batch(false), fifo_read_batch_time_us(0), events(nullptr)
 {
 }
 
-// Initialize the I2C communication and set up the accelerometer
+// Initialize the bus and set up the accelerometer
 void Accelerometer::init()
 {
-    // Initialize the I2C hardware with 400 kHz speed
-    i2c_init(i2c, 400 * 1000);
-
-    // Set the SDA and SCL pins for I2C
-    gpio_set_function(sda, GPIO_FUNC_I2C);
-    gpio_set_function(scl, GPIO_FUNC_I2C);
-    gpio_pull_up(sda);
-    gpio_pull_up(scl);
+    // Initialize the bus hardware and its pins
+    transport.init();
 
     // Verify the device by reading the WHO_AM_I register
     uint8_t who_am_i = read_register(0x0F); // WHO_AM_I register
@@ -33,18 +33,26 @@ void Accelerometer::init()
         printf("WHO_AM_I register read failed, got: 0x%x\n", who_am_i);
     }
 
-    // Set CTRL_REG1 to enable the accelerometer with 50Hz data rate (0b01000111)
-    write_register(0x20, 0b01000111); // CTRL_REG1
+    // Start the shadow copy from the reset values, then write all six control registers so that it matches the
+    // sensor whatever state it was left in
+    for (int i = 0; i < CTRL_COUNT; i++)
+    {
+        ctrl[i] = 0;
+    }
+    ctrl[0] = CTRL_REG1_XYZ_EN;
+    resolution = accel_resolution::normal;
+    set_data_rate(50);
+    set_scale(2);
+    ctrl_dirty = (1 << CTRL_COUNT) - 1;
+    flush_config();
 }
 
 // Get X, Y, and Z values in g's
 void Accelerometer::get_xyz_gs(float *x_g, float *y_g, float *z_g)
 {
     // Read the X-axis acceleration data
-    uint8_t xyz_starting_address = 0x28 | 0x80;                                 // Set MSB to 1 to enable multi-byte read
-    uint8_t accel_read_data[6];                                                 // Array to store the read data
-    i2c_write_blocking(i2c, ACCEL_I2C_ADDRESS, &xyz_starting_address, 1, true); // Send register address, keep the bus active (true)
-    i2c_read_blocking(i2c, ACCEL_I2C_ADDRESS, accel_read_data, 6, false);       // Read the data and send stop condition (false)
+    uint8_t accel_read_data[6] = {0};            // Array to store the read data
+    transport.read(OUT_X_L, accel_read_data, 6); // Read all six output registers in one auto-increment burst
 
     // Combine the high and low bytes for X, Y, Z acceleration data
     int16_t x_raw = (int16_t)(accel_read_data[1] << 8 | accel_read_data[0]); // X-axis data (High byte shifted left, OR'd with low byte)
@@ -57,151 +65,410 @@ void Accelerometer::get_xyz_gs(float *x_g, float *y_g, float *z_g)
     *z_g = convert_to_g(z_raw);
 }
 
+// Get X, Y, and Z values in milli-g
+void Accelerometer::get_xyz_mg(int16_t *x_mg, int16_t *y_mg, int16_t *z_mg)
+{
+    uint8_t accel_read_data[6] = {0};
+    transport.read(OUT_X_L, accel_read_data, 6);
+
+    *x_mg = convert_to_mg((int16_t)(accel_read_data[1] << 8 | accel_read_data[0]));
+    *y_mg = convert_to_mg((int16_t)(accel_read_data[3] << 8 | accel_read_data[2]));
+    *z_mg = convert_to_mg((int16_t)(accel_read_data[5] << 8 | accel_read_data[4]));
+}
+
+// Start streaming samples into the FIFO with a watermark interrupt on INT1
+bool Accelerometer::start_fifo(int data_rate, uint8_t watermark, uint int1_pin)
+{
+    int rate_bits = data_rate_bits(data_rate, resolution == accel_resolution::low_power);
+    if (rate_bits < 0 || watermark < 1 || watermark >= ACCEL_FIFO_DEPTH)
+    {
+        return false;
+    }
+    stop_fifo();
+
+    this->int1_pin = int1_pin;
+    this->watermark = watermark;
+    sample_period_us = 1000000 / data_rate;
+    batch_pending = false;
+    fifo_overruns = 0;
+    next_sample_time_us = 0;
+
+    // Only one accelerometer can own the interrupt handler
+    fifo_owner = this;
+    gpio_init(int1_pin);
+    gpio_set_dir(int1_pin, GPIO_IN);
+    gpio_add_raw_irq_handler(int1_pin, int1_irq_handler);
+    gpio_set_irq_enabled(int1_pin, GPIO_IRQ_EDGE_RISE, true);
+    irq_set_enabled(IO_IRQ_BANK0, true);
+
+    // Passing through bypass mode empties the FIFO, so the first batch starts fresh. The data rate, the FIFO and its
+    // interrupt are then switched on together, with any other pending settings.
+    write_register(FIFO_CTRL_REG, FIFO_MODE_BYPASS);
+    set_data_rate(data_rate);
+    update_ctrl(CTRL_REG3, CTRL_REG3_I1_WTM, CTRL_REG3_I1_WTM);
+    update_ctrl(CTRL_REG5, CTRL_REG5_FIFO_EN, CTRL_REG5_FIFO_EN);
+    flush_config();
+    write_register(FIFO_CTRL_REG, FIFO_MODE_STREAM | watermark); // Stream mode, INT1 once more than `watermark` samples
+    fifo_running = (read_register(FIFO_CTRL_REG) == (FIFO_MODE_STREAM | watermark));
+    if (!fifo_running)
+    {
+        stop_fifo();
+    }
+    return fifo_running;
+}
+
+void Accelerometer::stop_fifo()
+{
+    if (fifo_owner != this)
+    {
+        return;
+    }
+    finish_fifo_read(); // The transfers point into this object
+    gpio_set_irq_enabled(int1_pin, GPIO_IRQ_EDGE_RISE, false);
+    gpio_remove_raw_irq_handler(int1_pin, int1_irq_handler);
+    fifo_owner = nullptr;
+
+    write_register(FIFO_CTRL_REG, FIFO_MODE_BYPASS);
+    update_ctrl(CTRL_REG3, CTRL_REG3_I1_WTM, 0);
+    update_ctrl(CTRL_REG5, CTRL_REG5_FIFO_EN, 0);
+    flush_config();
+    fifo_running = false;
+}
+
+// INT1 is handled on the core that started the FIFO, which is the one reading it, so masking interrupts here keeps the
+// handler out. Otherwise it could land between the two words of the timestamp, or between reading the flag and
+// clearing it, which would lose the batch.
+bool Accelerometer::take_batch(uint64_t &time_us)
+{
+    uint32_t interrupts = save_and_disable_interrupts();
+    bool fresh_batch = batch_pending;
+    time_us = watermark_time_us;
+    batch_pending = false;
+    restore_interrupts(interrupts);
+    return fresh_batch;
+}
+
+bool Accelerometer::is_fifo_batch_ready() const
+{
+    // INT1 only rises once, so a batch left partly unread is spotted from the level of the pin instead
+    return fifo_running && (batch_pending || gpio_get(int1_pin));
+}
+
+// Drain the FIFO in one burst
+int Accelerometer::read_fifo(accel_sample samples[], int max_samples)
+{
+    if (!fifo_running)
+    {
+        return 0;
+    }
+    if (fifo_read_in_progress)
+    {
+        return 0; // The background read owns the burst buffer
+    }
+    uint64_t batch_time_us;
+    bool fresh_batch = take_batch(batch_time_us);
+
+    uint8_t fifo_source = 0;
+    if (!transport.read(FIFO_SRC_REG, &fifo_source, 1))
+    {
+        return -1;
+    }
+    int count = (fifo_source & FIFO_SRC_OVRN) ? ACCEL_FIFO_DEPTH : (fifo_source & FIFO_SRC_FSS_MASK);
+    count = (count < max_samples) ? count : max_samples;
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    // In FIFO mode the register address wraps from OUT_Z_H back to OUT_X_L, so one read returns every sample in turn
+    if (!transport.read(OUT_X_L, fifo_raw, count * 6))
+    {
+        return -1;
+    }
+    return unpack_fifo(fifo_raw, count, fifo_source, fresh_batch, batch_time_us, samples);
+}
+
+// Queue FIFO_SRC and a burst of one batch of samples, to run in the background while the caller carries on
+bool Accelerometer::start_fifo_read(accel_sample samples[], int max_samples)
+{
+    int count = (max_samples < watermark + 1) ? max_samples : watermark + 1;
+    if (!fifo_running || fifo_read_in_progress || count <= 0)
+    {
+        return false;
+    }
+    fifo_read_fresh_batch = take_batch(fifo_read_batch_time_us);
+    fifo_read_samples = samples;
+    fifo_read_count = count;
+
+    // INT1 guarantees at least `watermark + 1` samples, so the burst can be queued without waiting for FIFO_SRC
+    if (!transport.queue_read(FIFO_SRC_REG, &fifo_read_source, 1))
+    {
+        return false;
+    }
+    fifo_read_in_progress = true; // finish_fifo_read() must now wait for the first read, whatever happens next
+    fifo_read_queued = transport.queue_read(OUT_X_L, fifo_raw, count * 6);
+    return true;
+}
+
+bool Accelerometer::is_fifo_read_done()
+{
+    return !fifo_read_in_progress || transport.is_queue_done();
+}
+
+int Accelerometer::finish_fifo_read()
+{
+    if (!fifo_read_in_progress)
+    {
+        return 0;
+    }
+    fifo_read_in_progress = false;
+    if (!transport.finish_queue() || !fifo_read_queued)
+    {
+        return -1;
+    }
+    return unpack_fifo(fifo_raw, fifo_read_count, fifo_read_source, fifo_read_fresh_batch, fifo_read_batch_time_us,
+                       fifo_read_samples);
+}
+
+int Accelerometer::unpack_fifo(const uint8_t raw[], int count, uint8_t fifo_source, bool fresh_batch,
+                               uint64_t batch_time_us, accel_sample samples[])
+{
+    int level = fifo_source & FIFO_SRC_FSS_MASK;
+    if (fifo_source & FIFO_SRC_OVRN)
+    {
+        level = ACCEL_FIFO_DEPTH; // A full FIFO reports 0 unread samples, with the overrun flag set
+        fifo_overruns++;
+    }
+    count = (count < level) ? count : level; // Reads past the end of the FIFO only repeat the last sample
+
+    // Sample `watermark` arrived when INT1 rose. Without a fresh interrupt, carry on from the previous read.
+    uint64_t first_time_us;
+    if (fresh_batch && !(fifo_source & FIFO_SRC_OVRN))
+    {
+        first_time_us = batch_time_us - (uint64_t)watermark * sample_period_us;
+    }
+    else if (next_sample_time_us != 0 && !(fifo_source & FIFO_SRC_OVRN))
+    {
+        first_time_us = next_sample_time_us;
+    }
+    else
+    {
+        first_time_us = time_us_64() - (uint64_t)(level - 1) * sample_period_us; // Assume the newest is current
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        const uint8_t *sample = &raw[i * 6];
+        samples[i].x = (int16_t)(sample[1] << 8 | sample[0]);
+        samples[i].y = (int16_t)(sample[3] << 8 | sample[2]);
+        samples[i].z = (int16_t)(sample[5] << 8 | sample[4]);
+        samples[i].timestamp_us = first_time_us + (uint64_t)i * sample_period_us;
+    }
+    next_sample_time_us = first_time_us + (uint64_t)count * sample_period_us;
+    return count;
+}
+
+uint32_t Accelerometer::get_fifo_overrun_count() const
+{
+    return fifo_overruns;
+}
+
+void Accelerometer::set_event_queue(event_queue *queue)
+{
+    events = queue;
+}
+
+// INT1 went high: a batch is waiting. Only note the time, the bus is left to read_fifo().
+void Accelerometer::int1_irq_handler()
+{
+    Accelerometer *accel = fifo_owner;
+    if (accel == nullptr || !(gpio_get_irq_event_mask(accel->int1_pin) & GPIO_IRQ_EDGE_RISE))
+    {
+        return;
+    }
+    gpio_acknowledge_irq(accel->int1_pin, GPIO_IRQ_EDGE_RISE);
+    accel->watermark_time_us = time_us_64();
+    accel->batch_pending = true;
+    if (accel->events != nullptr)
+    {
+        accel->events->post(event_type::accel_watermark, (uint8_t)accel->int1_pin);
+    }
+}
+
 // Convert raw 16-bit accelerometer data to g's
 float Accelerometer::convert_to_g(int16_t raw_value)
 {
-    float gs_per_bit = static_cast<float>(RANGE_GS) / (1 << BITS); // Calculate the g's per bit
+    float gs_per_bit = raw_span_mg / 1000.0f / (1 << BITS); // Calculate the g's per bit
     return raw_value * gs_per_bit;                                 // Convert raw data to g's
 }
 
+// Convert raw 16-bit accelerometer data to milli-g
+int16_t Accelerometer::convert_to_mg(int16_t raw_value) const
+{
+    // The raw steps span raw_span_mg milli-g; add half a step before the shift to round
+    return (int16_t)(((int32_t)raw_value * raw_span_mg + (1 << (BITS - 1))) >> BITS);
+}
+
 // Helper method to read 16-bit (two registers) data
-int16_t Accelerometer::read_register_16(uint8_t reg_l, uint8_t reg_h)
+int16_t Accelerometer::read_register_16(uint8_t reg_l)
 {
-    uint8_t low_byte = read_register(reg_l);
-    uint8_t high_byte = read_register(reg_h);
-    return (int16_t)(high_byte << 8 | low_byte);
+    uint8_t data[2] = {0};
+    transport.read(reg_l, data, 2); // The high byte follows the low byte
+    return (int16_t)(data[1] << 8 | data[0]);
 }
 
 // Helper method to read 8-bit data from a register
 uint8_t Accelerometer::read_register(uint8_t reg)
 {
-    uint8_t data;
-    i2c_write_blocking(i2c, address, &reg, 1, true);  // Send register address
-    i2c_read_blocking(i2c, address, &data, 1, false); // Read data
+    uint8_t data = 0;
+    transport.read(reg, &data, 1);
     return data;
 }
 
 // Helper method to write 8-bit data to a register
 void Accelerometer::write_register(uint8_t reg, uint8_t value)
 {
-    uint8_t buf[2] = {reg, value};
-    i2c_write_blocking(i2c, address, buf, 2, false); // Write register and value
+    transport.write(reg, &value, 1);
 }
 
-int Accelerometer::set_scale(int scale)
+bool Accelerometer::set_data_rate(int rate)
 {
-    uint8_t CTRL_REG4_REG = 0x23;                // CTRL_REG4 register address
-    uint8_t current_register_value = 0b00000000; // Default value with other bits set to 0
+    int rate_bits = data_rate_bits(rate, resolution == accel_resolution::low_power);
+    if (rate_bits < 0)
+    {
+        return false;
+    }
+    update_ctrl(CTRL_REG1, CTRL_REG1_ODR_MASK, (uint8_t)rate_bits);
+    data_rate_hz = rate;
+    return true;
+}
 
-    // Set the FS[1:0] bits for full-scale selection
+bool Accelerometer::set_scale(int scale)
+{
+    // FS[1:0] in bits 5-4 of CTRL_REG4, and the span of the raw data from the datasheet sensitivities. These are
+    // 1, 2, 4 and 12 mg per 12-bit step, so ±16 g covers more than twice the span of ±8 g.
     uint8_t scale_bits;
-
-    // Switch case to handle different scale levels based on the table
+    int32_t span_mg;
     switch (scale)
     {
     case 2:
-        scale_bits = 0b00 << 2; // ±2g (00) (default)
+        scale_bits = 0b00 << 4;
+        span_mg = 4096;
         break;
     case 4:
-        scale_bits = 0b01 << 2; // ±4g (01)
+        scale_bits = 0b01 << 4;
+        span_mg = 8192;
         break;
     case 8:
-        scale_bits = 0b10 << 2; // ±8g (10)
+        scale_bits = 0b10 << 4;
+        span_mg = 16384;
         break;
     case 16:
-        scale_bits = 0b11 << 2; // ±16g (11)
+        scale_bits = 0b11 << 4;
+        span_mg = 49152;
         break;
     default:
-        printf("Invalid scale: %d g. No changes made.\n", scale);
-        return -1; // Error code for invalid scale
+        return false;
     }
+    update_ctrl(CTRL_REG4, CTRL_REG4_FS_MASK, scale_bits);
+    scale_g = scale;
+    raw_span_mg = span_mg;
+    return true;
+}
 
-    // Combine scale bits with the current register value (leave other bits unchanged)
-    uint8_t new_scale_register = (scale_bits & 0x0C) | (current_register_value & 0xF3); // Modify bits 2 and 3 (0x0C is the mask)
-
-    // Write to the CTRL_REG4 register
-    uint8_t buf[2];
-    buf[0] = CTRL_REG4_REG;      // Register address
-    buf[1] = new_scale_register; // Data to write
-
-    int result_scale = i2c_write_blocking(i2c0, ACCEL_I2C_ADDRESS, buf, 2, true); // Send register address and data
+bool Accelerometer::set_resolution(accel_resolution resolution)
+{
+    bool low_power = (resolution == accel_resolution::low_power);
+    int rate_bits = data_rate_bits(data_rate_hz, low_power);
+    if (rate_bits < 0)
+    {
+        return false;
+    }
+    // The same ODR bits mean 1.344 kHz in normal mode and 5.376 kHz in low power mode, so they are set again
+    uint8_t mode_bits = (uint8_t)(rate_bits | (low_power ? CTRL_REG1_LPEN : 0));
+    update_ctrl(CTRL_REG1, CTRL_REG1_ODR_MASK | CTRL_REG1_LPEN, mode_bits);
+    update_ctrl(CTRL_REG4, CTRL_REG4_HR, (resolution == accel_resolution::high) ? CTRL_REG4_HR : 0);
+    this->resolution = resolution;
+    return true;
+}
 
-    if (result_scale != 2)
+bool Accelerometer::flush_config()
+{
+    if (ctrl_dirty == 0)
     {
-        printf("Failed to write to I2C device\n");
-        return -1; // Error code for failed write
+        return true;
     }
-    else
+    // One burst from the first changed register to the last, rewriting any unchanged ones in between
+    int first = 0;
+    int last = CTRL_COUNT - 1;
+    while (!(ctrl_dirty & (1 << first)))
+    {
+        first++;
+    }
+    while (!(ctrl_dirty & (1 << last)))
+    {
+        last--;
+    }
+    if (!transport.write((uint8_t)(CTRL_REG1 + first), &ctrl[first], last - first + 1))
     {
-        printf("CTRL_REG4 register written successfully. Scale set to ±%d g\n", scale);
-        return 0; // Success code
+        return false;
     }
+    ctrl_dirty = 0;
+    return true;
+}
+
+int Accelerometer::get_data_rate() const
+{
+    return data_rate_hz;
+}
+
+int Accelerometer::get_scale() const
+{
+    return scale_g;
 }
 
-int Accelerometer::set_data_rate(int rate)
+accel_resolution Accelerometer::get_resolution() const
 {
-    uint8_t CTRL_REG1_REG = 0x20;                // CTRL_REG1 register address
-    uint8_t current_register_value = 0b01100111; // Default value (except for data rate bits)
+    return resolution;
+}
 
-    // Set the 4 most significant bits for data rate
-    uint8_t data_rate_bits;
+void Accelerometer::update_ctrl(uint8_t reg, uint8_t mask, uint8_t value)
+{
+    int index = reg - CTRL_REG1;
+    uint8_t updated = (uint8_t)((ctrl[index] & ~mask) | (value & mask));
+    if (updated != ctrl[index])
+    {
+        ctrl[index] = updated;
+        ctrl_dirty |= (uint8_t)(1 << index);
+    }
+}
 
+int Accelerometer::data_rate_bits(int rate, bool low_power)
+{
     // Switch case to handle different data rates based on the table
     switch (rate)
     {
     case 1:
-        data_rate_bits = 0b0001 << 4; // 1 Hz (0001)
-        break;
+        return 0b0001 << 4; // 1 Hz (0001)
     case 10:
-        data_rate_bits = 0b0010 << 4; // 10 Hz (0010)
-        break;
+        return 0b0010 << 4; // 10 Hz (0010)
     case 25:
-        data_rate_bits = 0b0011 << 4; // 25 Hz (0011)
-        break;
+        return 0b0011 << 4; // 25 Hz (0011)
     case 50:
-        data_rate_bits = 0b0100 << 4; // 50 Hz (0100)
-        break;
+        return 0b0100 << 4; // 50 Hz (0100)
     case 100:
-        data_rate_bits = 0b0101 << 4; // 100 Hz (0101)
-        break;
+        return 0b0101 << 4; // 100 Hz (0101)
     case 200:
-        data_rate_bits = 0b0110 << 4; // 200 Hz (0110)
-        break;
+        return 0b0110 << 4; // 200 Hz (0110)
     case 400:
-        data_rate_bits = 0b0111 << 4; // 400 Hz (0111)
-        break;
+        return 0b0111 << 4; // 400 Hz (0111)
     case 1600:
-        data_rate_bits = 0b1000 << 4; // 1.60 kHz (1000)
-        break;
+        return low_power ? 0b1000 << 4 : -1; // 1.60 kHz (1000), low power mode only
     case 1344:
-        data_rate_bits = 0b1001 << 4; // 1.344 kHz (1001)
-        break;
+        return low_power ? -1 : 0b1001 << 4; // 1.344 kHz (1001), normal and high resolution modes
     case 5376:
-        data_rate_bits = 0b1001 << 4; // 5.376 kHz (for low-power mode) (1001)
-        break;
+        return low_power ? 0b1001 << 4 : -1; // 5.376 kHz (1001), low power mode only
     default:
-        printf("Invalid data rate: %d Hz. No changes made.\n", rate);
-        return -1; // Error code for invalid data rate
-    }
-
-    // Combine data rate bits with the default register value (lower 4 bits unchanged)
-    uint8_t new_data_rate_register = (data_rate_bits & 0xF0) | (current_register_value & 0x0F);
-
-    // Write to the CTRL_REG1 register
-    uint8_t buf[2];
-    buf[0] = CTRL_REG1_REG;          // Register address
-    buf[1] = new_data_rate_register; // Data to write
-
-    int result_datarate = i2c_write_blocking(i2c0, ACCEL_I2C_ADDRESS, buf, 2, true); // Send register address and data
-
-    if (result_datarate != 2)
-    {
-        printf("Failed to write to I2C device\n");
-        return -1; // Error code for failed write
-    }
-    else
-    {
-        printf("CTRL_REG1 register written successfully. Data rate set to %d Hz\n", rate);
-        return 0; // Success code
+        return -1;
     }
 }
@@ -2,26 +2,84 @@
 #define ACCELEROMETER_H
 
 #include "pico/stdlib.h"
-#include "hardware/i2c.h"
+#include "accel_transport.h"
+#include "utils/event_queue.h"
+
+#define ACCEL_FIFO_DEPTH 32 // Samples held by the LIS3DH FIFO
+
+/*! \brief One reading of all three axes from the FIFO. */
+struct accel_sample {
+    int16_t x;             /*!< Raw X-axis data, left justified */
+    int16_t y;             /*!< Raw Y-axis data, left justified */
+    int16_t z;             /*!< Raw Z-axis data, left justified */
+    uint64_t timestamp_us; /*!< When the sample was taken, in microseconds since boot */
+};
+
+/*! \brief Output resolution, traded against power and the fastest data rates. */
+enum class accel_resolution {
+    low_power, /*!< 8-bit, the only mode with the 1.6 and 5.376 kHz data rates */
+    normal,    /*!< 10-bit */
+    high,      /*!< 12-bit */
+};
 
 /*! \brief Accelerometer class for interfacing with the MMA8652FC accelerometer.
  *
  * This class provides methods to initialize the accelerometer, read the X, Y, and Z acceleration data in g's,
- * and convert the raw 16-bit accelerometer data to g's. The accelerometer is connected via I2C and uses the
- * MMA8652FC driver.
+ * and convert the raw 16-bit accelerometer data to g's. Every register access goes through an `accel_transport`,
+ * so the same driver runs over I2C or over SPI, and FIFO batches can be read in the background with
+ * `start_fifo_read()`.
  */
 class Accelerometer {
 public:
-    Accelerometer(i2c_inst_t* i2c_instance, uint8_t sda_pin, uint8_t scl_pin, uint8_t address);
+    /*! \brief Creates a driver that reaches the sensor through `transport`, which must outlive it. */
+    Accelerometer(accel_transport &transport);
     
-    /*! \brief Initializes the I2C communication and sets up the accelerometer.
+    /*! \brief Initializes the bus and sets up the accelerometer.
      *
-     * This method initializes the I2C hardware with a 400 kHz speed, sets the SDA and SCL pins for I2C communication,
-     * and verifies the accelerometer by reading the WHO_AM_I register. It also sets the CTRL_REG1 register to enable
-     * the accelerometer with a 50 Hz data rate.
+     * This method sets up the transport's bus and pins and verifies the accelerometer by reading the WHO_AM_I
+     * register. It then writes the whole configuration in one burst: 50 Hz, ±2 g, normal resolution.
     */
     void init();
 
+    /*! \brief Selects the data rate. Like the other settings, it takes effect at the next `flush_config()`.
+     *
+     * \param rate In Hz: 1, 10, 25, 50, 100, 200, 400 or 1344, or 1600 or 5376 instead of 1344 in low power mode.
+     * \return false, changing nothing, if the rate is not available at the selected resolution.
+     */
+    bool set_data_rate(int rate);
+
+    /*! \brief Selects the full scale range.
+     *
+     * \param scale ±2, 4, 8 or 16 g.
+     * \return false, changing nothing, if the scale is not one of these.
+     */
+    bool set_scale(int scale);
+
+    /*! \brief Selects the output resolution.
+     *
+     * \return false, changing nothing, if the selected data rate is not available at this resolution.
+     */
+    bool set_resolution(accel_resolution resolution);
+
+    /*! \brief Writes every setting changed since the last flush to the sensor, in one auto-increment burst.
+     *
+     * The settings are kept in a copy of CTRL_REG1 to CTRL_REG6, so changing them never reads the sensor and a flush
+     * with nothing changed does not touch the bus at all. The conversions to g and milli-g follow the new scale at
+     * once, so only readings taken after the flush should be converted with it.
+     *
+     * \return false if the sensor did not respond, in which case the changes stay pending.
+     */
+    bool flush_config();
+
+    /*! \brief Returns the selected data rate in Hz, flushed or not. */
+    int get_data_rate() const;
+
+    /*! \brief Returns the selected full scale range in g, flushed or not. */
+    int get_scale() const;
+
+    /*! \brief Returns the selected resolution, flushed or not. */
+    accel_resolution get_resolution() const;
+
     /*! \brief Reads the X, Y, and Z acceleration data in g's.
      *
      * This method reads the X, Y, and Z acceleration data from the accelerometer and converts the raw 16-bit data
@@ -33,31 +91,175 @@ public:
     */
     void get_xyz_gs(float* x_g, float* y_g, float* z_g);  // Ensure this declaration is present
 
+    /*! \brief Reads the X, Y, and Z acceleration data in milli-g, without floating point.
+     *
+     * \param x_mg Receives the X-axis acceleration in milli-g.
+     * \param y_mg Receives the Y-axis acceleration in milli-g.
+     * \param z_mg Receives the Z-axis acceleration in milli-g.
+    */
+    void get_xyz_mg(int16_t* x_mg, int16_t* y_mg, int16_t* z_mg);
+
+    /*! \brief Starts collecting samples in the sensor FIFO, with an interrupt on INT1 each time a batch is ready.
+     *
+     * The FIFO runs in stream mode: it always holds the newest 32 samples. When it holds more than `watermark`
+     * samples, INT1 goes high. The interrupt handler only timestamps the batch, so nothing touches the bus until
+     * `read_fifo()` is called.
+     *
+     * \param data_rate The sample rate in Hz. Must be one of the rates accepted by `set_data_rate()`, which this calls.
+     * \param watermark Samples to collect before INT1 goes high, 1 to 31.
+     * \param int1_pin The GPIO pin wired to the sensor's INT1 output.
+     * \return false if the data rate or watermark is invalid or the sensor could not be configured.
+     */
+    bool start_fifo(int data_rate, uint8_t watermark, uint int1_pin);
+
+    /*! \brief Stops the FIFO and the INT1 interrupt, leaving the sensor sampling as after `init()`. */
+    void stop_fifo();
+
+    /*! \brief Returns true once the FIFO holds more than the watermark, so `read_fifo()` will not wait. */
+    bool is_fifo_batch_ready() const;
+
+    /*! \brief Reads every sample waiting in the FIFO in a single auto-increment burst.
+     *
+     * Samples are timestamped from the time INT1 went high and the sample rate, so the timestamps are evenly spaced
+     * and do not depend on when this is called.
+     *
+     * \param samples Receives the samples, oldest first.
+     * \param max_samples Size of `samples`. Samples that do not fit stay in the FIFO for the next call.
+     * \return The number of samples read, or -1 if the bus transfer failed.
+     */
+    int read_fifo(accel_sample samples[], int max_samples);
+
+    /*! \brief Queues a read of the batch waiting in the FIFO and returns straight away.
+     *
+     * The read runs in the background while the caller carries on, e.g. with LED rendering or DSP. It takes the samples that made
+     * INT1 go high, `watermark + 1` at most; any more stay in the FIFO and keep INT1 high for the next batch. Collect
+     * the samples with `finish_fifo_read()`.
+     *
+     * \param samples Receives the samples, oldest first. Must stay valid until `finish_fifo_read()` returns.
+     * \param max_samples Size of `samples`.
+     * \return false if the FIFO is not running, a read is already in progress or the bus queue is full.
+     */
+    bool start_fifo_read(accel_sample samples[], int max_samples);
+
+    /*! \brief Returns true once the read queued by `start_fifo_read()` has finished, or if there is none. */
+    bool is_fifo_read_done();
+
+    /*! \brief Completes the read queued by `start_fifo_read()`, waiting for it if need be, and timestamps the samples
+     * as `read_fifo()` does.
+     *
+     * \return The number of samples read, 0 if no read was queued, or -1 if the bus transfer failed.
+     */
+    int finish_fifo_read();
+
+    /*! \brief Returns the number of times the FIFO filled up before it was read, losing its oldest samples. */
+    uint32_t get_fifo_overrun_count() const;
+
+    /*! \brief Posts an `event_type::accel_watermark` to `queue` from the INT1 interrupt each time a batch is ready, or
+     * stops posting if `queue` is null.
+     */
+    void set_event_queue(event_queue *queue);
+
+    /*! \brief Converts raw 16-bit accelerometer data, e.g. from `read_fifo()`, to g's. */
+    float convert_to_g(int16_t raw_value);
+
+    /*! \brief Converts raw 16-bit accelerometer data to milli-g, rounded to the nearest.
+     *
+     * Integer only, so it costs a multiply and a shift where `convert_to_g()` needs soft-float on the RP2040. The raw
+     * data itself is already a Q15 fraction of the full scale, for code that wants to stay in Q15.
+     */
+    int16_t convert_to_mg(int16_t raw_value) const;
+
 private:
-    i2c_inst_t* i2c;
-    uint8_t sda;
-    uint8_t scl;
-    uint8_t address;
+    accel_transport &transport;
 
-    int16_t read_register_16(uint8_t reg_l, uint8_t reg_h);
+    /*! \brief Reads a little endian pair of registers in one auto-increment burst. */
+    int16_t read_register_16(uint8_t reg_l);
     uint8_t read_register(uint8_t reg);
     void write_register(uint8_t reg, uint8_t value);
-    float convert_to_g(int16_t raw_value);
 
-    int set_scale(int scale);
+    /*! \brief Returns the ODR bits of CTRL_REG1 for a data rate in Hz, or -1 if the rate is not supported in the
+     * given mode.
+     */
+    static int data_rate_bits(int rate, bool low_power);
 
-    /*! \brief Set the data rate of the accelerometer
-    * 
-    * This method sets the data rate of the accelerometer to the specified value. The data rate determines how often the accelerometer
-    * samples the acceleration data. The available data rates are 1, 10, 25, 50, 100, 200, 400, 1600, 1344, and 5376 Hz.
-    * 
-    * \param rate The desired data rate in Hz. Must be one of the available data rates.
-    * \return 0 if the data rate was set successfully, -1 if the data rate is invalid or the write operation failed.
-    */
-    int set_data_rate(int rate);
+    /*! \brief Changes bits of a control register in the shadow copy, marking it for the next flush. */
+    void update_ctrl(uint8_t reg, uint8_t mask, uint8_t value);
+
+    /*! \brief Converts a burst of raw FIFO samples and timestamps them.
+     *
+     * \param fifo_source FIFO_SRC_REG as read just before the burst.
+     * \param fresh_batch Whether INT1 rose since the previous read, at `batch_time_us`.
+     * \return The number of samples, which may be fewer than `count` if the FIFO held fewer.
+     */
+    int unpack_fifo(const uint8_t raw[], int count, uint8_t fifo_source, bool fresh_batch, uint64_t batch_time_us,
+                    accel_sample samples[]);
+
+    /*! \brief Takes the flag set by the INT1 interrupt and clears it, with the time of the edge.
+     *
+     * \param time_us Set to the time INT1 last went high.
+     * \return true if INT1 rose since the flag was last taken.
+     */
+    bool take_batch(uint64_t &time_us);
+
+    static void int1_irq_handler();
 
-    static constexpr int16_t RANGE_GS = 4;  // ±2g range
     static constexpr int BITS = 16;         // 16-bit accelerometer data
+
+    // Control registers, kept in the shadow copy
+    static constexpr uint8_t CTRL_REG1 = 0x20;
+    static constexpr uint8_t CTRL_REG3 = 0x22;
+    static constexpr uint8_t CTRL_REG4 = 0x23;
+    static constexpr uint8_t CTRL_REG5 = 0x24;
+    static constexpr uint8_t CTRL_REG6 = 0x25;
+    static constexpr int CTRL_COUNT = CTRL_REG6 - CTRL_REG1 + 1;
+    static constexpr uint8_t CTRL_REG1_ODR_MASK = 0xF0;
+    static constexpr uint8_t CTRL_REG1_LPEN = 0x08;     // Low power mode
+    static constexpr uint8_t CTRL_REG1_XYZ_EN = 0x07;   // All three axes enabled
+    static constexpr uint8_t CTRL_REG4_FS_MASK = 0x30;  // Full scale selection, bits 5-4
+    static constexpr uint8_t CTRL_REG4_HR = 0x08;       // High resolution mode
+
+    // Registers and bits used by the FIFO mode
+    static constexpr uint8_t OUT_X_L = 0x28;
+    static constexpr uint8_t FIFO_CTRL_REG = 0x2E;
+    static constexpr uint8_t FIFO_SRC_REG = 0x2F;
+    static constexpr uint8_t CTRL_REG3_I1_WTM = 0x04; // FIFO watermark interrupt on INT1
+    static constexpr uint8_t CTRL_REG5_FIFO_EN = 0x40;
+    static constexpr uint8_t FIFO_MODE_BYPASS = 0x00;
+    static constexpr uint8_t FIFO_MODE_STREAM = 0x80;
+    static constexpr uint8_t FIFO_SRC_OVRN = 0x40;
+    static constexpr uint8_t FIFO_SRC_FSS_MASK = 0x1F;
+
+    // Configuration: a copy of CTRL_REG1 to CTRL_REG6 and what it means
+    uint8_t ctrl[CTRL_COUNT];
+    uint8_t ctrl_dirty;                      // Bit n set when CTRL_REG1 + n differs from the sensor
+    int data_rate_hz;
+    int scale_g;
+    accel_resolution resolution;
+    int32_t raw_span_mg;                     // Milli-g covered by the 2^BITS raw steps at the selected scale
+
+    // FIFO state
+    uint int1_pin;                           // Pin wired to INT1, while the FIFO is running
+    bool fifo_running;
+    uint32_t sample_period_us;               // Time between samples at the FIFO's data rate
+    uint8_t watermark;
+    volatile uint64_t watermark_time_us;     // When INT1 last went high
+    volatile bool batch_pending;             // Set by the INT1 interrupt, cleared by take_batch()
+    uint32_t fifo_overruns;
+    uint64_t next_sample_time_us;            // Timestamp due to the next sample read, or 0 before the first read
+    uint8_t fifo_raw[ACCEL_FIFO_DEPTH * 6];  // Bytes of the latest burst
+
+    // Background FIFO read, from start_fifo_read() to finish_fifo_read()
+    uint8_t fifo_read_source;                // FIFO_SRC_REG, read ahead of the samples
+    accel_sample *fifo_read_samples;
+    int fifo_read_count;
+    bool fifo_read_in_progress;
+    bool fifo_read_queued;                   // Whether the burst made it into the queue behind FIFO_SRC
+    bool fifo_read_fresh_batch;
+    uint64_t fifo_read_batch_time_us;
+
+    event_queue *events;                     // Told about each batch by the INT1 interrupt, or null
+
+    static Accelerometer *fifo_owner;        // The accelerometer serviced by the INT1 interrupt handler
 };
 
 #endif // ACCELEROMETER_H
@@ -0,0 +1,79 @@
+#include "button.h"
+#include "hardware/gpio.h"
+
+event_queue *button::edge_queue = nullptr;
+uint button::edge_pin = 0;
+
+button::button()
+    : pin(0), pressed(false), raw_pressed(false), raw_time_us(0), last_change_us(0), bounces(0)
+{
+}
+
+void button::init(uint pin, event_queue &queue)
+{
+    this->pin = pin;
+    gpio_init(pin);
+    gpio_set_dir(pin, GPIO_IN);
+    pressed = !gpio_get(pin);
+    raw_pressed = pressed;
+    raw_time_us = event_time_us();
+    last_change_us = raw_time_us - BUTTON_DEBOUNCE_US; // The first edge is accepted straight away
+
+    edge_queue = &queue;
+    edge_pin = pin;
+    gpio_set_irq_enabled_with_callback(pin, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, true, &gpio_irq_callback);
+}
+
+bool button::filter(const event &edge, event &change)
+{
+    if (edge.type != event_type::button_edge || edge.source != pin)
+    {
+        return false;
+    }
+    raw_pressed = edge.active;
+    raw_time_us = edge.time_us;
+    if (edge.active == pressed || edge.time_us - last_change_us < BUTTON_DEBOUNCE_US)
+    {
+        bounces++;
+        return false;
+    }
+    accept(edge.active, edge.time_us, change);
+    return true;
+}
+
+bool button::update(uint32_t now_us, event &change)
+{
+    if (raw_pressed == pressed || now_us - last_change_us < BUTTON_DEBOUNCE_US)
+    {
+        return false;
+    }
+    accept(raw_pressed, raw_time_us, change); // Timed at the edge that left it in this state
+    return true;
+}
+
+bool button::is_pressed() const
+{
+    return pressed;
+}
+
+uint32_t button::get_bounce_count() const
+{
+    return bounces;
+}
+
+void button::accept(bool pressed, uint32_t time_us, event &change)
+{
+    this->pressed = pressed;
+    last_change_us = time_us;
+    change = {pressed ? event_type::button_pressed : event_type::button_released, (uint8_t)pin, pressed, time_us};
+}
+
+void button::gpio_irq_callback(uint gpio, uint32_t)
+{
+    if (gpio != edge_pin || edge_queue == nullptr)
+    {
+        return;
+    }
+    // Several edges may have been latched together, so report the level now rather than the edges
+    edge_queue->post(event_type::button_edge, (uint8_t)gpio, !gpio_get(gpio));
+}
@@ -0,0 +1,70 @@
+#ifndef BUTTON_H
+#define BUTTON_H
+
+#include <stdint.h>
+#include "pico/stdlib.h"
+#include "utils/event_queue.h"
+
+#define BUTTON_DEBOUNCE_US 10000 // Edges this soon after an accepted change are contact bounce
+
+/*! \brief An active low push button, reported through an `event_queue` and debounced by the consumer.
+ *
+ * The interrupt handler does as little as possible: on every edge it posts an `event_type::button_edge` with the
+ * level it sees. The main loop passes those events through `filter()`, which accepts a change straight away and
+ * ignores the bounce that follows it for `BUTTON_DEBOUNCE_US`, so presses are seen with no added delay and a bouncy
+ * press counts once. If the bounce leaves the button in a new state, `update()` accepts it once the window is over.
+ */
+class button
+{
+public:
+    button();
+
+    /*! \brief Sets up the pin and starts posting its edges.
+     *
+     * Uses the SDK's GPIO callback, which is shared by every pin, so only one button can be attached. Pins with a
+     * raw handler, such as the accelerometer's INT1, are unaffected.
+     *
+     * \param pin The GPIO pin, low while pressed.
+     * \param queue Receives the raw edges. Must outlive the button.
+     */
+    void init(uint pin, event_queue &queue);
+
+    /*! \brief Debounces one raw edge.
+     *
+     * \param edge An `event_type::button_edge` event from this button.
+     * \param change Receives an `event_type::button_pressed` or `button_released` event, timed at the edge.
+     * \return true if the edge was accepted as a press or release.
+     */
+    bool filter(const event &edge, event &change);
+
+    /*! \brief Accepts a change that bounce hid, once the window after the last accepted change is over. Call it
+     * regularly, for example once per pass of the main loop.
+     *
+     * \return true, with the change, if the button settled in a new state.
+     */
+    bool update(uint32_t now_us, event &change);
+
+    /*! \brief Returns the debounced state. */
+    bool is_pressed() const;
+
+    /*! \brief Returns the number of edges dismissed as bounce. */
+    uint32_t get_bounce_count() const;
+
+private:
+    /*! \brief Accepts a change to `pressed` that happened at `time_us`. */
+    void accept(bool pressed, uint32_t time_us, event &change);
+
+    static void gpio_irq_callback(uint gpio, uint32_t events);
+
+    static event_queue *edge_queue; // Queue of the attached button, used by the interrupt handler
+    static uint edge_pin;           // Pin of the attached button
+
+    uint pin;
+    bool pressed;             // Debounced state
+    bool raw_pressed;         // State at the latest edge
+    uint32_t raw_time_us;     // Time of the latest edge
+    uint32_t last_change_us;  // Time of the latest accepted change
+    uint32_t bounces;
+};
+
+#endif // BUTTON_H
@@ -0,0 +1,203 @@
+#include "i2c_dma.h"
+#include <string.h>
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+
+i2c_dma i2c_dma::engines[2];
+
+// Constructor
+i2c_dma::i2c_dma()
+    : i2c(nullptr), initialised(false), tx_channel(-1), rx_channel(-1), queue(), active(nullptr),
+      active_aborted(false), commands()
+{
+}
+
+i2c_dma &i2c_dma::for_instance(i2c_inst_t *i2c)
+{
+    i2c_dma &engine = engines[i2c_hw_index(i2c)];
+    engine.i2c = i2c;
+    return engine;
+}
+
+void i2c_dma::init(uint sda_pin, uint scl_pin, uint baudrate)
+{
+    if (initialised)
+    {
+        return;
+    }
+    i2c_init(i2c, baudrate);
+    gpio_set_function(sda_pin, GPIO_FUNC_I2C);
+    gpio_set_function(scl_pin, GPIO_FUNC_I2C);
+    gpio_pull_up(sda_pin);
+    gpio_pull_up(scl_pin);
+
+    tx_channel = dma_claim_unused_channel(true);
+    rx_channel = dma_claim_unused_channel(true);
+
+    // The block requests data from the DMA, and interrupts only when a transfer ends or is refused
+    i2c_hw_t *hw = i2c_get_hw(i2c);
+    hw->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS | I2C_IC_DMA_CR_RDMAE_BITS;
+    hw->intr_mask = I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+    uint irq = I2C0_IRQ + i2c_hw_index(i2c);
+    irq_set_exclusive_handler(irq, (i2c_hw_index(i2c) == 0) ? i2c0_irq_handler : i2c1_irq_handler);
+    irq_set_enabled(irq, true);
+    initialised = true;
+}
+
+bool i2c_dma::submit(i2c_transfer &transfer, uint8_t address, const uint8_t *write_data, size_t write_length,
+                     uint8_t *read_data, size_t read_length)
+{
+    if (transfer.status == i2c_transfer_status::queued || transfer.status == i2c_transfer_status::busy)
+    {
+        return false; // Still in use
+    }
+    if (!initialised || write_length > I2C_DMA_MAX_WRITE || read_length > I2C_DMA_MAX_READ ||
+        write_length + read_length == 0)
+    {
+        transfer.status = i2c_transfer_status::failed;
+        return false;
+    }
+
+    transfer.address = address;
+    memcpy(transfer.write_data, write_data, write_length);
+    transfer.write_length = (uint8_t)write_length;
+    transfer.read_data = read_data;
+    transfer.read_length = (uint16_t)read_length;
+    transfer.status = i2c_transfer_status::queued;
+    if (!queue.push(&transfer))
+    {
+        transfer.status = i2c_transfer_status::failed;
+        return false;
+    }
+
+    // If the bus was idle nothing will take the transfer off the queue, so run the interrupt handler to start it. When
+    // a transfer is still on the bus, its STOP interrupt starts this one.
+    if (active == nullptr)
+    {
+        irq_set_pending(I2C0_IRQ + i2c_hw_index(i2c));
+    }
+    return true;
+}
+
+bool i2c_dma::transfer_blocking(uint8_t address, const uint8_t *write_data, size_t write_length, uint8_t *read_data,
+                                size_t read_length)
+{
+    i2c_transfer transfer;
+    if (!submit(transfer, address, write_data, write_length, read_data, read_length))
+    {
+        return false;
+    }
+    while (!transfer.is_finished())
+    {
+        tight_loop_contents();
+    }
+    return transfer.status == i2c_transfer_status::done;
+}
+
+bool i2c_dma::is_idle() const
+{
+    return active == nullptr && queue.size() == 0;
+}
+
+// Put the next queued transfer on the bus. Only called from the interrupt handler.
+void i2c_dma::start_next()
+{
+    i2c_transfer *transfer;
+    if (!queue.pop(transfer))
+    {
+        return;
+    }
+
+    // One command word per byte: data to write, or a read request. A repeated start turns the bus round for the
+    // first read and a STOP follows the last byte.
+    size_t count = 0;
+    for (size_t i = 0; i < transfer->write_length; i++)
+    {
+        commands[count++] = transfer->write_data[i];
+    }
+    for (size_t i = 0; i < transfer->read_length; i++)
+    {
+        bool restart = (i == 0 && transfer->write_length > 0);
+        commands[count++] = I2C_IC_DATA_CMD_CMD_BITS | (restart ? I2C_IC_DATA_CMD_RESTART_BITS : 0);
+    }
+    commands[count - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+    // The target address can only change while the block is disabled
+    i2c_hw_t *hw = i2c_get_hw(i2c);
+    hw->enable = 0;
+    hw->tar = transfer->address;
+    hw->enable = 1;
+
+    active_aborted = false;
+    active = transfer;
+    transfer->status = i2c_transfer_status::busy;
+
+    // Arm the receiving channel first so no byte is missed
+    if (transfer->read_length > 0)
+    {
+        dma_channel_config rx_config = dma_channel_get_default_config(rx_channel);
+        channel_config_set_transfer_data_size(&rx_config, DMA_SIZE_8);
+        channel_config_set_read_increment(&rx_config, false);
+        channel_config_set_write_increment(&rx_config, true);
+        channel_config_set_dreq(&rx_config, i2c_get_dreq(i2c, false));
+        dma_channel_configure(rx_channel, &rx_config, transfer->read_data, &hw->data_cmd, transfer->read_length, true);
+    }
+    dma_channel_config tx_config = dma_channel_get_default_config(tx_channel);
+    channel_config_set_transfer_data_size(&tx_config, DMA_SIZE_32);
+    channel_config_set_read_increment(&tx_config, true);
+    channel_config_set_write_increment(&tx_config, false);
+    channel_config_set_dreq(&tx_config, i2c_get_dreq(i2c, true));
+    dma_channel_configure(tx_channel, &tx_config, &hw->data_cmd, commands, count, true);
+}
+
+void i2c_dma::finish(bool succeeded)
+{
+    i2c_transfer *transfer = active;
+    active = nullptr;
+    if (transfer->callback != nullptr)
+    {
+        transfer->callback(*transfer, succeeded);
+    }
+    transfer->status = succeeded ? i2c_transfer_status::done : i2c_transfer_status::failed; // Hands it back
+}
+
+void i2c_dma::handle_irq()
+{
+    i2c_hw_t *hw = i2c_get_hw(i2c);
+    uint32_t status = hw->intr_stat;
+    if (status & I2C_IC_INTR_STAT_R_TX_ABRT_BITS)
+    {
+        // Not acknowledged. The block flushes its FIFO and sends a STOP, so stop the DMA before clearing the abort.
+        dma_channel_abort(tx_channel);
+        dma_channel_abort(rx_channel);
+        hw->clr_tx_abrt;
+        active_aborted = true;
+    }
+    if (status & I2C_IC_INTR_STAT_R_STOP_DET_BITS)
+    {
+        hw->clr_stop_det;
+        if (active != nullptr)
+        {
+            if (!active_aborted && active->read_length > 0)
+            {
+                dma_channel_wait_for_finish_blocking(rx_channel); // The last byte is already in the RX FIFO
+            }
+            finish(!active_aborted);
+        }
+    }
+    if (active == nullptr)
+    {
+        start_next();
+    }
+}
+
+void i2c_dma::i2c0_irq_handler()
+{
+    engines[0].handle_irq();
+}
+
+void i2c_dma::i2c1_irq_handler()
+{
+    engines[1].handle_irq();
+}
@@ -0,0 +1,120 @@
+#ifndef I2C_DMA_H
+#define I2C_DMA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "utils/spsc_queue.h"
+
+#define I2C_DMA_QUEUE_DEPTH 8 // Transfers that can wait behind the one on the bus
+#define I2C_DMA_MAX_WRITE 8   // Bytes written by one transfer, e.g. a register address and its data
+#define I2C_DMA_MAX_READ 192  // Bytes read by one transfer, enough for the whole LIS3DH FIFO
+
+/*! \brief Where a transfer is on its way through an `i2c_dma` engine. */
+enum class i2c_transfer_status {
+    idle,   /*!< Never submitted */
+    queued, /*!< Waiting behind other transfers */
+    busy,   /*!< On the bus */
+    done,   /*!< Finished, with any read data in place */
+    failed, /*!< Not acknowledged by the device, or could not be queued */
+};
+
+struct i2c_transfer;
+
+/*! \brief Called from the I2C interrupt when a transfer finishes, just before its status changes. Must not submit. */
+typedef void (*i2c_transfer_callback_t)(i2c_transfer &transfer, bool succeeded);
+
+/*! \brief One write-then-read transaction with a device, owned by the caller until it finishes.
+ *
+ * The bytes to write are copied in by `i2c_dma::submit()`. The read buffer is filled by DMA, so it must stay valid
+ * until the status is `done` or `failed`.
+ */
+struct i2c_transfer {
+    uint8_t address = 0;
+    uint8_t write_data[I2C_DMA_MAX_WRITE] = {};
+    uint8_t write_length = 0;
+    uint8_t *read_data = nullptr;
+    uint16_t read_length = 0;
+    volatile i2c_transfer_status status = i2c_transfer_status::idle;
+    i2c_transfer_callback_t callback = nullptr; // Optional
+    void *context = nullptr;                    // For the callback's use
+
+    /*! \brief Returns true once the transfer has finished, successfully or not. */
+    bool is_finished() const
+    {
+        return status == i2c_transfer_status::done || status == i2c_transfer_status::failed;
+    }
+};
+
+/*! \brief Runs queued I2C transfers in the background with DMA, one I2C block per engine.
+ *
+ * Each transfer writes its bytes and then, after a repeated start, reads into the caller's buffer. A TX DMA channel
+ * feeds the command words to the block and an RX DMA channel collects the data, so the CPU only steps in at the end of
+ * each transfer, when the STOP interrupt completes it and puts the next one on the bus. Sensor reads therefore run
+ * alongside LED rendering and DSP instead of holding up the caller.
+ *
+ * Transfers must be submitted from one core. Callbacks run in the interrupt handler and must be short. Once an engine
+ * is running, every device on its bus must go through it: the blocking SDK functions wait for the STOP flag that the
+ * engine's interrupt clears.
+ */
+class i2c_dma
+{
+public:
+    i2c_dma(const i2c_dma &) = delete;
+    i2c_dma &operator=(const i2c_dma &) = delete;
+
+    /*! \brief Returns the engine that drives `i2c`. There is one per I2C block, shared by every device on the bus. */
+    static i2c_dma &for_instance(i2c_inst_t *i2c);
+
+    /*! \brief Sets up the I2C block, its pins, two DMA channels and the interrupt.
+     *
+     * Later calls, e.g. from a second device on the same bus, return straight away.
+     */
+    void init(uint sda_pin, uint scl_pin, uint baudrate);
+
+    /*! \brief Queues a transfer.
+     *
+     * \param transfer The transfer to fill in and queue. Its callback and context are left as they are.
+     * \param address The 7-bit device address.
+     * \param write_data Bytes to write first, copied into the transfer.
+     * \param write_length At most `I2C_DMA_MAX_WRITE`.
+     * \param read_data Receives the bytes read.
+     * \param read_length At most `I2C_DMA_MAX_READ`.
+     * \return false, with the status set to `failed`, if the lengths are invalid or the queue is full.
+     */
+    bool submit(i2c_transfer &transfer, uint8_t address, const uint8_t *write_data, size_t write_length,
+                uint8_t *read_data, size_t read_length);
+
+    /*! \brief Queues a transfer and waits for it to finish.
+     *
+     * \return true if the device acknowledged the whole transfer.
+     */
+    bool transfer_blocking(uint8_t address, const uint8_t *write_data, size_t write_length, uint8_t *read_data,
+                           size_t read_length);
+
+    /*! \brief Returns true when no transfer is queued or on the bus. */
+    bool is_idle() const;
+
+private:
+    i2c_dma();
+
+    void start_next();
+    void finish(bool succeeded);
+    void handle_irq();
+    static void i2c0_irq_handler();
+    static void i2c1_irq_handler();
+
+    static i2c_dma engines[2];
+
+    i2c_inst_t *i2c;
+    bool initialised;
+    int tx_channel;
+    int rx_channel;
+    spsc_queue<i2c_transfer *, I2C_DMA_QUEUE_DEPTH> queue;  // Filled by submit(), emptied by the interrupt
+    i2c_transfer *volatile active;                          // The transfer on the bus
+    volatile bool active_aborted;
+    uint32_t commands[I2C_DMA_MAX_WRITE + I2C_DMA_MAX_READ]; // Command words for the active transfer
+};
+
+#endif // I2C_DMA_H
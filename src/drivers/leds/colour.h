@@ -2,28 +2,51 @@
 #define COLOUR_H
 
 #include <cstdint>
-#include <algorithm>  // Include for std::max and std::min
+#include <array>
+#include <type_traits>
 
+/*! \brief A colour held both as RGB and as HSV, with every component 0-255.
+ *
+ * Hue runs once around the colour wheel over 0-255 (red at 0, green near 85, blue near 170). The class is six bytes,
+ * trivially copyable and usable in constant expressions, so colours and whole palettes can be built at compile time.
+ * Going from HSV to RGB takes only integer multiplies and shifts; going from RGB to HSV takes two divisions.
+ */
 class colour {
 public:
+    /*! \brief Black. */
+    constexpr colour() : red(0), green(0), blue(0), hue(0), saturation(0), value(0) {}
+
     // Constructor that initializes the color with R, G, and B values
-    colour(uint8_t r, uint8_t g, uint8_t b);
+    constexpr colour(uint8_t r, uint8_t g, uint8_t b)
+        : red(r), green(g), blue(b), hue(0), saturation(0), value(0) {
+        update_hsv();  // Update HSV values based on the initial RGB values
+    }
+
+    /*! \brief Returns the colour with the given hue, saturation and value. */
+    static constexpr colour from_hsv(uint8_t h, uint8_t s, uint8_t v) {
+        colour result;
+        result.hue = h;
+        result.saturation = s;
+        result.value = v;
+        result.update_rgb();
+        return result;
+    }
 
     // Getter methods for each RGB component
     /*! \brief Returns the  `uint8_t` Red Value (0-255)*/
-    uint8_t get_red() const;
+    constexpr uint8_t get_red() const { return red; }
     /*! \brief Returns the  `uint8_t` Green Value (0-255)*/
-    uint8_t get_green() const;
+    constexpr uint8_t get_green() const { return green; }
     /*! \brief Returns the  `uint8_t` Blue Value (0-255)*/
-    uint8_t get_blue() const;
+    constexpr uint8_t get_blue() const { return blue; }
 
     // Getter methods for each HSV component
     /*! \brief Returns the  `uint8_t` Hue Value (0-255)*/
-    uint8_t get_hue() const;
+    constexpr uint8_t get_hue() const { return hue; }
     /*! \brief Returns the  `uint8_t` Saturation Value (0-255)*/
-    uint8_t get_saturation() const;
+    constexpr uint8_t get_saturation() const { return saturation; }
     /*! \brief Returns the  `uint8_t` Value Value (0-255)*/
-    uint8_t get_value() const;
+    constexpr uint8_t get_value() const { return value; }
 
     // Setter methods for RGB values
     /*! \brief Sets the  `uint8_t` Red Value (0-255)*/
@@ -34,7 +57,7 @@ public:
     void set_blue(uint8_t b);
 
     // Setter methods for HSV values
-    /*! \brief Sets the  `uint8_t` Hue Value (0-255)*/
+    /*! \brief Sets the  `uint8_t` Hue Value (0-255). Values wrap around the colour wheel. */
     void set_hue(uint8_t h);
     /*! \brief Sets the  `uint8_t` Saturation Value (0-255)*/
     void set_saturation(uint8_t s);
@@ -45,10 +68,85 @@ private:
     uint8_t red, green, blue;   // RGB components
     uint8_t hue, saturation, value; // HSV components
 
-    // Private methods for internal calculations
-    void update_hsv();
-    void update_rgb();
-    void handle_hue_overflow();
+    // x / 255, rounded down, for any x from 0 to 65535
+    static constexpr uint32_t divide_by_255(uint32_t x) {
+        return (x + 1 + (x >> 8)) >> 8;
+    }
+
+    // Recalculate HSV from RGB
+    constexpr void update_hsv() {
+        uint8_t cmax = red > green ? (red > blue ? red : blue) : (green > blue ? green : blue); // Max of R, G, B
+        uint8_t cmin = red < green ? (red < blue ? red : blue) : (green < blue ? green : blue); // Min of R, G, B
+        int32_t diff = cmax - cmin; // Difference between max and min
+
+        value = cmax;                                       // Calculate V (value)
+        saturation = (cmax == 0) ? 0 : (diff * 255) / cmax; // Calculate S (saturation)
+
+        if (diff == 0) {
+            hue = 0;
+            return;
+        }
+        // Work in sixths of a turn, 256 steps each, so the result wraps cleanly into 0-255
+        int32_t sixths = 0;
+        if (cmax == red) {
+            sixths = ((green - blue) * 256) / diff;
+        } else if (cmax == green) {
+            sixths = 512 + ((blue - red) * 256) / diff;
+        } else {
+            sixths = 1024 + ((red - green) * 256) / diff;
+        }
+        if (sixths < 0) {
+            sixths += 1536;
+        }
+        hue = static_cast<uint8_t>((sixths + 3) / 6);
+    }
+
+    // Recalculate RGB from HSV without branches: the sector of the hue picks which of v, p, q and t each channel takes
+    constexpr void update_rgb() {
+        uint32_t sixths = hue * 6u;       // 0 to 1530
+        uint32_t sector = sixths >> 8;    // 0 to 5
+        uint32_t fraction = sixths & 255; // Position within the sector
+        uint32_t v = value;
+        uint32_t candidates[4] = {
+            v,                                                                       // v
+            divide_by_255(v * (255 - saturation)),                                   // p
+            divide_by_255(v * (255 - divide_by_255(saturation * fraction))),         // q
+            divide_by_255(v * (255 - divide_by_255(saturation * (255 - fraction)))), // t
+        };
+        // Two bits per channel (r, g, b from the bottom) selecting the candidate, for each sector
+        constexpr uint8_t selectors[6] = {
+            0 | (3 << 2) | (1 << 4), // v, t, p
+            2 | (0 << 2) | (1 << 4), // q, v, p
+            1 | (0 << 2) | (3 << 4), // p, v, t
+            1 | (2 << 2) | (0 << 4), // p, q, v
+            3 | (1 << 2) | (0 << 4), // t, p, v
+            0 | (1 << 2) | (2 << 4), // v, p, q
+        };
+        uint8_t selector = selectors[sector];
+        red = static_cast<uint8_t>(candidates[selector & 3]);
+        green = static_cast<uint8_t>(candidates[(selector >> 2) & 3]);
+        blue = static_cast<uint8_t>(candidates[(selector >> 4) & 3]);
+    }
 };
 
+static_assert(sizeof(colour) == 6, "colour should stay packed");
+static_assert(std::is_trivially_copyable<colour>::value, "colour should be cheap to copy");
+
+/*! \brief 256 colours indexed by a level, so mapping a level to a colour is one table lookup. */
+typedef std::array<colour, 256> colour_palette;
+
+/*! \brief Builds a palette that sweeps the hue from `first_hue` to `last_hue` at a fixed saturation and value.
+ *
+ * Entry 0 has `first_hue` and entry 255 has `last_hue`. Use in a `constexpr` variable so the table is generated at
+ * compile time.
+ */
+constexpr colour_palette make_hue_palette(uint8_t first_hue, uint8_t last_hue, uint8_t saturation, uint8_t value) {
+    colour_palette palette{};
+    for (int i = 0; i < 256; i++) {
+        int hue = first_hue + ((last_hue - first_hue) * i) / 255;
+        palette[i] = colour::from_hsv(static_cast<uint8_t>(hue), saturation, value);
+    }
+    return palette;
+}
+
 #endif // COLOUR_H
@@ -1,86 +1,293 @@
+#include <algorithm>
+#include <cmath>
 #include "led_array.h"
 #include "pico/stdlib.h"
 #include "hardware/gpio.h"
 #include "hardware/pio.h"
-#include "WS2812.pio.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "led_strip_manager.h"
+
+led_array *led_array::active_strips[LED_ARRAY_MAX_STRIPS] = {};
+uint8_t led_array::output_luts[LED_ARRAY_MAX_STRIPS][256];
+
+// Bit position of the red, green and blue bytes in a transmitted word for each led_channel_order
+static const uint8_t channel_shifts[6][3] = {
+    {16, 24, 8}, // grb
+    {24, 16, 8}, // rgb
+    {16, 8, 24}, // brg
+    {24, 8, 16}, // rbg
+    {8, 24, 16}, // gbr
+    {8, 16, 24}, // bgr
+};
+
+// A mask with one bit per LED, wrapped in a struct so that it can be returned
+struct led_mask {
+    uint32_t words[LED_MASK_WORDS];
+};
+
+// Converts a -1 terminated list of LED indices into a mask, ignoring indices outside the array
+static led_mask indices_to_mask(const int indices[], int num_leds) {
+    led_mask mask = {};
+    for (int j = 0; j < num_leds && indices[j] != -1; j++) {
+        if (indices[j] >= 0 && indices[j] < num_leds) {
+            mask.words[indices[j] / 32] |= 1u << (indices[j] % 32);
+        }
+    }
+    return mask;
+}
 
 // Constructor
-led_array::led_array()
-    : led_pin(0), num_leds(0) {
+led_array::led_array(uint32_t *led_data, uint32_t *tx_buffer, int capacity)
+    : led_data(led_data), tx_buffer(tx_buffer), capacity(capacity), led_pin(0), num_leds(0), pio(pio0), sm(0),
+      dma_channel(-1), busy(false), frame_open(false), dirty(false), must_send(false), brightness(255), gamma(1.0f),
+      channel_order(led_channel_order::grb), output_lut(nullptr), output_shifts(nullptr) {
+}
+
+// Destructor
+led_array::~led_array() {
+    release();
 }
 
 // Initializes the LED array with a specified pin and number of LEDs
 void led_array::init(uint pin, int num_leds) {
+    release(); // Starting again on a different pin must not leak the old state machine
     this->led_pin = pin;
-    this->num_leds = num_leds;
+    this->num_leds = (num_leds < capacity) ? num_leds : capacity;
 
     // Initialize the LED data array to 0
     for (int i = 0; i < this->num_leds; i++) {
         led_data[i] = 0;
     }
 
-    // Initialize PIO and program offset
-    uint pio_program_offset = pio_add_program(pio0, &ws2812_program);
-    ws2812_program_init(pio0, 0, pio_program_offset, led_pin, 800000, false);
+    // Claim a state machine running the ws2812 program
+    if (!led_strip_manager::claim_output(led_pin, pio, sm)) {
+        panic("No free PIO state machine for the LEDs on GPIO %u", led_pin);
+    }
+
+    // DMA channel that copies the transmit buffer into the state machine's TX FIFO, paced by the FIFO's DREQ
+    dma_channel = dma_claim_unused_channel(true);
+    dma_channel_config config = dma_channel_get_default_config(dma_channel);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_32);
+    channel_config_set_read_increment(&config, true);
+    channel_config_set_write_increment(&config, false);
+    channel_config_set_dreq(&config, pio_get_dreq(pio, sm, true));
+    dma_channel_configure(dma_channel, &config, &pio->txf[sm], tx_buffer, this->num_leds, false);
+    dma_channel_set_irq1_enabled(dma_channel, true);
 
+    // Every strip shares one handler, installed along with the first strip
+    bool first_strip = true;
+    for (led_array *&strip : active_strips) {
+        first_strip = first_strip && (strip == nullptr);
+    }
+    for (int slot = 0; slot < LED_ARRAY_MAX_STRIPS; slot++) {
+        if (active_strips[slot] == nullptr) {
+            active_strips[slot] = this;
+            output_lut = output_luts[slot];
+            break;
+        }
+    }
+    build_output_lut();
+    if (first_strip) {
+        irq_add_shared_handler(LED_ARRAY_DMA_IRQ, dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(LED_ARRAY_DMA_IRQ, true);
+    }
+
+    frame_open = false;
+    must_send = true; // The strip's contents are unknown, so always send the first frame
+    dirty = true;
     clear_all(); // Initialize all LEDs to off
 }
 
+int led_array::get_num_leds() const {
+    return num_leds;
+}
+
+void led_array::release() {
+    if (dma_channel < 0) {
+        return;
+    }
+    wait_until_ready();
+    dma_channel_set_irq1_enabled(dma_channel, false);
+
+    bool last_strip = true;
+    for (led_array *&strip : active_strips) {
+        if (strip == this) {
+            strip = nullptr;
+        }
+        last_strip = last_strip && (strip == nullptr);
+    }
+    if (last_strip) {
+        irq_remove_handler(LED_ARRAY_DMA_IRQ, dma_irq_handler);
+    }
+
+    dma_channel_unclaim(dma_channel);
+    dma_channel = -1;
+    output_lut = nullptr;
+    led_strip_manager::release_output(pio, sm);
+}
+
 // Sets the color of an individual LED in the array
 void led_array::set_colour_individual(int index, colour colour) {
     bool is_valid_index = (index >= 0 && index < num_leds);
     if (is_valid_index) {
-        led_data[index] = colour_to_led_data(colour);
-        update_leds();
+        write_led(index, colour_to_led_data(colour));
+        end_change();
     }
 }
 
 // Sets the color of a specific range of LEDs
 void led_array::set_range_color(int indices[], colour colour) {
-    uint32_t color = colour_to_led_data(colour);
+    set_mask_colour(indices_to_mask(indices, num_leds).words, colour);
+}
 
-    for (int i = 0; i < num_leds; i++) {
-        for (int j = 0; j < num_leds; j++) {  // Check if i is in the indices array
-            if (indices[j] == -1) {  // Sentinel value to end the loop
-                break;
-            }
-            if (indices[j] == i) {
-                led_data[i] = color;
+// Sets the color of all LEDs except those in a specified range
+void led_array::set_excluded_range_color(int indices[], colour colour) {
+    set_mask_colour(indices_to_mask(indices, num_leds).words, colour, true);
+}
+
+// Sets the colour of the LEDs selected by a mask
+void led_array::set_mask_colour(const uint32_t mask[], colour colour, bool excluded) {
+    uint32_t data = colour_to_led_data(colour);
+    uint32_t invert = excluded ? 0xFFFFFFFF : 0;
+
+    for (int word = 0; word * 32 < num_leds; word++) {
+        uint32_t bits = mask[word] ^ invert;
+        while (bits != 0) {
+            int i = word * 32 + __builtin_ctz(bits);
+            if (i >= num_leds) {
                 break;
             }
+            write_led(i, data);
+            bits &= bits - 1; // Clear the lowest set bit
         }
     }
+    end_change();
+}
 
-    update_leds();  // Update the LEDs after setting all colors
+// Sets a run of LEDs to one colour
+void led_array::fill_slice(int start, int count, colour colour) {
+    if (count <= 0 || num_leds == 0) {
+        return;
+    }
+    uint32_t data = colour_to_led_data(colour);
+    if (count > num_leds) {
+        count = num_leds;
+    }
+    int index = wrap_index(start);
+    for (int i = 0; i < count; i++) {
+        write_led(index, data);
+        index = (index + 1 == num_leds) ? 0 : index + 1;
+    }
+    end_change();
 }
 
-// Sets the color of all LEDs except those in a specified range
-void led_array::set_excluded_range_color(int indices[], colour colour) {
-    for (int i = 0; i < num_leds; i++) {
-        bool in_range = false;
-        for (int j = 0; j < num_leds; j++) {  // Check if i is in the indices array
-            if (indices[j] == -1) {  // Sentinel value to end the loop
-                break;
-            }
-            if (indices[j] == i) {
-                in_range = true;
-                break;
-            }
+// Copies a run of colours onto the LEDs
+void led_array::set_slice(int start, const colour colours[], int count) {
+    if (count <= 0 || num_leds == 0) {
+        return;
+    }
+    if (count > num_leds) {
+        count = num_leds;
+    }
+    int index = wrap_index(start);
+    for (int i = 0; i < count; i++) {
+        write_led(index, colour_to_led_data(colours[i]));
+        index = (index + 1 == num_leds) ? 0 : index + 1;
+    }
+    end_change();
+}
+
+// Copies a run of packed colours onto the LEDs
+void led_array::set_packed_slice(int start, const uint32_t data[], int count) {
+    if (count <= 0 || num_leds == 0) {
+        return;
+    }
+    if (count > num_leds) {
+        count = num_leds;
+    }
+    int index = wrap_index(start);
+    for (int i = 0; i < count; i++) {
+        write_led(index, data[i]);
+        index = (index + 1 == num_leds) ? 0 : index + 1;
+    }
+    end_change();
+}
+
+// Rotates the LEDs along the array
+void led_array::rotate(int steps) {
+    if (num_leds == 0) {
+        return;
+    }
+    int split = num_leds - wrap_index(steps); // This LED ends up first
+    if (split == num_leds) {
+        return;
+    }
+    // Rotate in place by reversing both parts and then the whole strip
+    std::reverse(led_data, led_data + split);
+    std::reverse(led_data + split, led_data + num_leds);
+    std::reverse(led_data, led_data + num_leds);
+    dirty = true;
+    end_change();
+}
+
+// Shifts the LEDs along the array
+void led_array::shift(int steps, colour fill) {
+    uint32_t data = colour_to_led_data(fill);
+    if (steps >= 0) {
+        // Work from the end so that every source is read before it is overwritten
+        for (int i = num_leds - 1; i >= 0; i--) {
+            write_led(i, (i - steps >= 0) ? led_data[i - steps] : data);
         }
-        if (!in_range) {
-            led_data[i] = colour_to_led_data(colour);
+    } else {
+        for (int i = 0; i < num_leds; i++) {
+            write_led(i, (i - steps < num_leds) ? led_data[i - steps] : data);
         }
     }
-
-    update_leds();  // Update the LEDs after setting all colors
+    end_change();
 }
 
 // Clears the color of all LEDs in the array
 void led_array::clear_all() {
     for (int i = 0; i < num_leds; i++) {
-        led_data[i] = 0;
+        write_led(i, 0);
     }
-    update_leds();
+    end_change();
+}
+
+void led_array::begin_frame() {
+    frame_open = true;
+}
+
+bool led_array::commit_frame() {
+    frame_open = false;
+    if (!dirty) {
+        return false;
+    }
+    dirty = false;
+    if (!frame_changed()) {
+        return false;
+    }
+    show();
+    return true;
+}
+
+void led_array::write_led(int index, uint32_t data) {
+    if (led_data[index] != data) {
+        led_data[index] = data;
+        dirty = true;
+    }
+}
+
+void led_array::end_change() {
+    if (!frame_open) {
+        commit_frame();
+    }
+}
+
+int led_array::wrap_index(int index) const {
+    index %= num_leds;
+    return (index < 0) ? index + num_leds : index;
 }
 
 // Converts RGB color values into a 32-bit data format
@@ -88,10 +295,112 @@ uint32_t led_array::colour_to_led_data(colour colour) {
     return (colour.get_red() << 24) | (colour.get_green() << 16) | (colour.get_blue() << 8);
 }
 
-// Updates the LED array to reflect the current color settings
-void led_array::update_leds() {
+void led_array::set_brightness(uint8_t brightness) {
+    this->brightness = brightness;
+    output_stage_changed();
+}
+
+uint8_t led_array::get_brightness() const {
+    return brightness;
+}
+
+void led_array::set_gamma(float gamma) {
+    this->gamma = gamma;
+    output_stage_changed();
+}
+
+void led_array::set_channel_order(led_channel_order order) {
+    channel_order = order;
+    output_stage_changed();
+}
+
+void led_array::output_stage_changed() {
+    if (output_lut == nullptr) {
+        return; // init() builds the tables once the strip has a slot, and sends the first frame regardless
+    }
+    build_output_lut();
+    dirty = true; // Every LED may look different even though led_data is unchanged
+    end_change();
+}
+
+// Only runs when a setting changes, so the floating point maths stays out of the per frame path
+void led_array::build_output_lut() {
+    output_shifts = channel_shifts[static_cast<int>(channel_order)];
+    for (int level = 0; level < 256; level++) {
+        uint32_t corrected = level;
+        if (gamma != 1.0f) {
+            corrected = static_cast<uint32_t>(powf(level / 255.0f, gamma) * 255.0f + 0.5f);
+        }
+        output_lut[level] = static_cast<uint8_t>((corrected * brightness + 127) / 255);
+    }
+}
+
+// Starts sending the current colours to the LEDs
+void led_array::show() {
+    prepare_show();
+    dma_channel_start(dma_channel);
+}
+
+// One lookup per channel applies gamma and brightness, and the shift puts the byte where the strip expects it
+uint32_t led_array::output_word(uint32_t data) const {
+    return (static_cast<uint32_t>(output_lut[data >> 24]) << output_shifts[0]) |
+           (static_cast<uint32_t>(output_lut[(data >> 16) & 0xFF]) << output_shifts[1]) |
+           (static_cast<uint32_t>(output_lut[(data >> 8) & 0xFF]) << output_shifts[2]);
+}
+
+// tx_buffer is only written here and read by the DMA, so it still holds the last frame sent and can be compared
+// without waiting for the DMA to finish
+bool led_array::frame_changed() const {
+    if (must_send) {
+        return true;
+    }
+    for (int i = 0; i < num_leds; i++) {
+        if (output_word(led_data[i]) != tx_buffer[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void led_array::prepare_show() {
+    wait_until_ready();
     for (int i = 0; i < num_leds; i++) {
-        pio_sm_put_blocking(pio0, 0, led_data[i]);
+        tx_buffer[i] = output_word(led_data[i]);
+    }
+    must_send = false;
+    busy = true;
+    dma_channel_set_read_addr(dma_channel, tx_buffer, false);
+    dma_channel_set_trans_count(dma_channel, num_leds, false);
+}
+
+bool led_array::is_busy() const {
+    return busy;
+}
+
+void led_array::wait_until_ready() const {
+    while (busy) {
+        tight_loop_contents();
+    }
+}
+
+// The DMA has handed the last word to the PIO. The words still in the FIFO have to be shifted out before the reset
+// time starts, so the frame is latched a little later.
+void led_array::dma_irq_handler() {
+    for (led_array *leds : active_strips) {
+        if (leds == nullptr || !dma_channel_get_irq1_status(leds->dma_channel)) {
+            continue;
+        }
+        dma_channel_acknowledge_irq1(leds->dma_channel);
+
+        int words_in_flight = (leds->num_leds < LED_ARRAY_FIFO_WORDS) ? leds->num_leds : LED_ARRAY_FIFO_WORDS;
+        uint64_t latch_delay_us = words_in_flight * LED_ARRAY_WORD_TIME_US + LED_ARRAY_RESET_TIME_US;
+        if (add_alarm_in_us(latch_delay_us, latch_complete, leds, true) < 0) {
+            leds->busy = false; // No alarm slots left, so release the strip rather than leave show() waiting forever
+        }
     }
-    sleep_us(700);  // Adjust the sleep time based on your requirements
+}
+
+int64_t led_array::latch_complete(alarm_id_t, void *user_data) {
+    static_cast<led_array *>(user_data)->busy = false;
+    return 0; // Do not reschedule
 }
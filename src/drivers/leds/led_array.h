@@ -2,29 +2,58 @@
 #define LED_ARRAY_H
 
 #include "colour.h"  // Include the colour class
+#include "pico/stdlib.h"
 #include "hardware/pio.h"
+#include "hardware/irq.h"
 
-/*! \brief Default constructor that initialises the LED array object.
-     *
-     * This constructor initializes the `led_pin` and `num_leds` members but does not perform any 
-     * setup operations. The actual initialization of the LED array should be done using the `init()` method.
-*/
+#define LED_ARRAY_MAX_LEDS 1024                          // Longest strip supported
+#define LED_ARRAY_MAX_STRIPS 8                           // Strips that can be driven at once, one per state machine
+#define LED_MASK_WORDS ((LED_ARRAY_MAX_LEDS + 31) / 32) // Words in a mask with one bit per LED of the longest strip
+#define LED_ARRAY_DMA_IRQ DMA_IRQ_1     // DMA_IRQ_0 belongs to the microphone
+#define LED_ARRAY_WORD_TIME_US 30       // 24 bits at 800 kHz
+#define LED_ARRAY_FIFO_WORDS 9          // Joined 8 word TX FIFO plus the output shift register
+#define LED_ARRAY_RESET_TIME_US 280     // Time the line must stay low for the LEDs to latch
+
+/*! \brief Order in which an LED expects the three colour bytes, first byte sent first. */
+enum class led_channel_order {
+    grb, /*!< WS2812 and WS2812B */
+    rgb,
+    brg,
+    rbg,
+    gbr,
+    bgr,
+};
+
+class led_strip_manager;
+class led_renderer;
+
+/*! \brief A chain of WS2812 LEDs driven by its own PIO state machine and DMA channel.
+ *
+ * The colour storage is provided by the derived class, normally `led_strip<N>`, so the LED count is fixed at compile
+ * time. Nothing is set up until `init()` is called.
+ */
 class led_array {
 public:
-    // Constructor
-    led_array();
+    /*! \brief Waits for any frame still being sent, then releases the DMA channel and state machine. */
+    ~led_array();
+
+    led_array(const led_array &) = delete;
+    led_array &operator=(const led_array &) = delete;
 
     /*! \brief Initialises the LED array with a specified pin and number of LEDs.
      * \ingroup pico_stdio
      *
-     * This method sets up the LED array by initialising the given number of LEDs. 
-     * It also configures the PIO (Programmable I/O) and the program offset for controlling the LED chain.
+     * This method sets up the LED array by initialising the given number of LEDs. It claims a free PIO state machine
+     * (the ws2812 program is only loaded into each PIO once) and a DMA channel to feed it.
      *
      * \param pin The GPIO pin used to control the LED array.
-     * \param num_leds The number of LEDs in the array.
+     * \param num_leds The number of LEDs in the array, at most the capacity of the strip.
      */
     void init(uint pin, int num_leds);
 
+    /*! \brief Returns the number of LEDs in the array. */
+    int get_num_leds() const;
+
     /*! \brief Sets the color of an individual LED in the array.
     * \ingroup pico_stdio
     *
@@ -69,6 +98,63 @@ public:
     */
     void set_excluded_range_color(int indices[], colour colour);
 
+    /*! \brief Sets the colour of every LED whose bit is set in a mask.
+    * \ingroup pico_stdio
+    *
+    * LED `i` is bit `i % 32` of `mask[i / 32]`. Runs in time linear in the number of LEDs, skipping empty words.
+    *
+    * \param mask At least `(num_leds + 31) / 32` words. Bits beyond the end of the array are ignored.
+    * \param colour The colour object to set the masked LEDs to
+    * \param excluded If true, set the LEDs whose bit is clear instead.
+    */
+    void set_mask_colour(const uint32_t mask[], colour colour, bool excluded = false);
+
+    /*! \brief Sets `count` consecutive LEDs starting at `start` to one colour, wrapping past the end of the array.
+    * \ingroup pico_stdio
+    *
+    * \param start The first LED to set. May be negative or beyond the end; it is wrapped into the array.
+    * \param count The number of LEDs to set. At most the whole array is set.
+    * \param colour The colour object to set the LEDs to
+    */
+    void fill_slice(int start, int count, colour colour);
+
+    /*! \brief Copies a contiguous range of colours onto consecutive LEDs starting at `start`, wrapping past the end.
+    * \ingroup pico_stdio
+    *
+    * \param start The LED that receives `colours[0]`. Wrapped into the array like `fill_slice`.
+    * \param colours The colours to copy.
+    * \param count The number of colours. At most the whole array is set.
+    */
+    void set_slice(int start, const colour colours[], int count);
+
+    /*! \brief Copies colours already packed by `colour_to_led_data()` onto consecutive LEDs, wrapping like `set_slice`.
+    * \ingroup pico_stdio
+    *
+    * For code that composes whole frames, such as effects, without going through `colour` for every LED.
+    *
+    * \param start The LED that receives `data[0]`.
+    * \param data The packed colours to copy.
+    * \param count The number of colours. At most the whole array is set.
+    */
+    void set_packed_slice(int start, const uint32_t data[], int count);
+
+    /*! \brief Moves every LED `steps` places towards the end of the array, wrapping the ones that fall off around.
+    * \ingroup pico_stdio
+    *
+    * Works in place. Unless `steps` is a whole number of turns the strip counts as changed.
+    *
+    * \param steps Places to move. Negative values rotate towards the start.
+    */
+    void rotate(int steps);
+
+    /*! \brief Moves every LED `steps` places towards the end of the array, filling the vacated LEDs with a colour.
+    * \ingroup pico_stdio
+    *
+    * \param steps Places to move. Negative values shift towards the start.
+    * \param fill The colour object to set the vacated LEDs to
+    */
+    void shift(int steps, colour fill);
+
     /*! \brief Clears the color of all LEDs in the array.
     * \ingroup pico_stdio
     *
@@ -77,35 +163,158 @@ public:
     */
     void clear_all();
 
-private:
-    /*! \brief Updates the LED array to reflect the current color settings.
+    /*! \brief Starts a frame: the setters stop sending the strip until `commit_frame()` is called.
+    * \ingroup pico_stdio
+    *
+    * Outside a frame every setter sends the whole strip as soon as it has changed anything. Inside a frame, any number
+    * of setters can be called and the strip is sent once at the end.
+    */
+    void begin_frame();
+
+    /*! \brief Ends the frame started by `begin_frame()` and sends the strip if it differs from the last frame sent.
     * \ingroup pico_stdio
     *
-    * This function sends the current color data stored in the `led_data` array to the LED hardware.
-    * It iterates over each LED in the array and sends the corresponding color data to the PIO (Programmable I/O)
-    * using the `pio_sm_put_blocking` function. After updating the LEDs, the function pauses for a brief period
-    * to ensure proper timing.
+    * The frame is compared with what the strip is showing rather than with the state before `begin_frame()`, so a
+    * frame that clears the strip and draws the same picture again is not sent.
+    *
+    * \return true if the strip was sent, false if it already shows this frame.
+    */
+    bool commit_frame();
+
+    /*! \brief Scales every colour sent to the strip, 255 being full brightness.
+    * \ingroup pico_stdio
     *
-    * \note The sleep time can be reduced to 530us, but lower values may cause flickering or other issues.
+    * Applied by the output stage while the strip is sent, so the stored colours keep their full resolution. Counts as
+    * a change to every LED.
     */
-    uint32_t colour_to_led_data(colour colour);
+    void set_brightness(uint8_t brightness);
+
+    /*! \brief Returns the brightness set by `set_brightness()`. */
+    uint8_t get_brightness() const;
+
+    /*! \brief Sets the gamma applied to each channel before the brightness, 1 (the default) turning correction off.
+    * \ingroup pico_stdio
+    *
+    * Around 2.2 to 2.8 makes the steps of a fade look even to the eye. Counts as a change to every LED.
+    */
+    void set_gamma(float gamma);
+
+    /*! \brief Sets the order in which the strip expects the colour bytes. The default suits WS2812 LEDs. */
+    void set_channel_order(led_channel_order order);
+
+    /*! \brief Sends the current colours to the LED hardware without waiting for them to arrive.
+    * \ingroup pico_stdio
+    *
+    * The colours are passed through the output stage into a transmit buffer and a DMA channel feeds them to the ws2812 PIO state machine, so the
+    * `led_data` array can be changed again straight away. When the DMA finishes, a hardware alarm marks the frame as
+    * latched once the PIO FIFO has drained and the line has been low for the reset time.
+    *
+    * \note If the previous frame is still being sent or latched, this waits for it first.
+    */
+    void show();
+
+    /*! \brief Returns true while a frame is being sent to the LEDs or latched. */
+    bool is_busy() const;
+
+    /*! \brief Blocks until the last frame passed to `show()` has been latched by the LEDs. */
+    void wait_until_ready() const;
 
     /*! \brief Converts RGB color values into a 32-bit data format for the LED array.
     * \ingroup pico_stdio
     *
     * This function takes the red, green, and blue color components as input and combines them into a single
     * 32-bit integer. The resulting value is formatted as 0xRRGGBB00, with the red component occupying the most 
-    * significant byte, followed by the green and blue components.
+    * significant byte, followed by the green and blue components. The output stage reorders the bytes for the strip
+    * when it is sent.
     *
     * \param colour The colour object to convert to a 32-bit integer.
     * \return A 32-bit integer representing the combined RGB color, suitable for use in the LED data array.
     */
-    void update_leds();
+    static uint32_t colour_to_led_data(colour colour);
+
+    /*! \brief Mixes two packed colours, `weight` running from 0 (all `from`) to 256 (all `to`).
+    *
+    * Red and blue are blended together in the two halves of one word, then green on its own.
+    */
+    static inline uint32_t blend_led_data(uint32_t from, uint32_t to, uint32_t weight) {
+        from >>= 8;
+        to >>= 8;
+        uint32_t red_blue = (((from & 0xFF00FF) * (256 - weight) + (to & 0xFF00FF) * weight) >> 8) & 0xFF00FF;
+        uint32_t green = (((from & 0x00FF00) * (256 - weight) + (to & 0x00FF00) * weight) >> 8) & 0x00FF00;
+        return (red_blue | green) << 8;
+    }
+
+    /*! \brief Scales every channel of a packed colour by `level`, from 0 (black) to 256 (unchanged). */
+    static inline uint32_t scale_led_data(uint32_t data, uint32_t level) {
+        data >>= 8;
+        uint32_t red_blue = (((data & 0xFF00FF) * level) >> 8) & 0xFF00FF;
+        uint32_t green = (((data & 0x00FF00) * level) >> 8) & 0x00FF00;
+        return (red_blue | green) << 8;
+    }
+
+protected:
+    /*! \brief Creates an LED array that keeps its colours in storage owned by the derived class.
+     *
+     * \param led_data Storage for the colour of each LED.
+     * \param tx_buffer Storage for the copy being sent by the DMA, the same size as `led_data`.
+     * \param capacity The number of words in each buffer.
+     */
+    led_array(uint32_t *led_data, uint32_t *tx_buffer, int capacity);
+
+private:
+    friend class led_strip_manager;
+    friend class led_renderer;
+    /*! \brief Stores the data for one LED, marking the frame dirty if it changed. */
+    void write_led(int index, uint32_t data);
+
+    /*! \brief Sends the strip after a setter, unless a frame is open. */
+    void end_change();
+
+    /*! \brief Wraps any LED index into the range 0 to num_leds - 1. */
+    int wrap_index(int index) const;
+
+    /*! \brief Returns the word sent for a colour, after the output stage. */
+    uint32_t output_word(uint32_t data) const;
+
+    /*! \brief Returns true if the colours, after the output stage, differ from the last frame sent. */
+    bool frame_changed() const;
+
+    /*! \brief Fills the transmit buffer from the colours and arms the DMA channel without starting it. */
+    void prepare_show();
+
+    /*! \brief Recalculates the output stage tables from the gamma, brightness and channel order. */
+    void build_output_lut();
+
+    /*! \brief Rebuilds the output stage after a setting changed and resends the strip like any other change. */
+    void output_stage_changed();
+
+    /*! \brief Gives back the DMA channel and state machine claimed by `init()`. */
+    void release();
+
+    static void dma_irq_handler();
+    static int64_t latch_complete(alarm_id_t id, void *user_data);
 
     // Member variables
-    uint32_t led_data[100];  // Array to store color data for each LED
-    uint led_pin;            // The pin used for controlling the LED array
-    int num_leds;            // Number of LEDs in the array
+    uint32_t *led_data;                     // Array to store color data for each LED
+    uint32_t *tx_buffer;                    // Copy of led_data being read by the DMA
+    int capacity;                           // Size of both buffers
+    uint led_pin;                           // The pin used for controlling the LED array
+    int num_leds;                           // Number of LEDs in the array
+    PIO pio;                                // PIO block running the ws2812 program for this strip
+    uint sm;                                // State machine within `pio`
+    int dma_channel;                        // Channel feeding the PIO TX FIFO, or -1 before init
+    volatile bool busy;                     // Set by show(), cleared by the latch alarm
+    bool frame_open;                        // Between begin_frame() and commit_frame()
+    bool dirty;                             // led_data or the output stage changed since the last commit
+    bool must_send;                         // Send the next frame even if tx_buffer already matches it
+    uint8_t brightness;                     // Output stage scale, 255 for full brightness
+    float gamma;                            // Output stage gamma, 1 for none
+    led_channel_order channel_order;        // Byte order expected by the strip
+    uint8_t *output_lut;                    // Each level after gamma and brightness, or null before init
+    const uint8_t *output_shifts;           // Bit position of the red, green and blue bytes in a sent word
+
+    static led_array *active_strips[LED_ARRAY_MAX_STRIPS]; // Strips serviced by the DMA interrupt handler
+    static uint8_t output_luts[LED_ARRAY_MAX_STRIPS][256]; // Output stage of each active strip, kept off the stack
 };
 
 #endif // LED_ARRAY_H
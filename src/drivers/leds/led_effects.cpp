@@ -0,0 +1,251 @@
+#include <string.h>
+#include <array>
+#include "led_effects.h"
+#include "pico/stdlib.h"
+#include "utils/dsp_tables.h"
+
+// One breath, (1 - cos) / 2 from 0 to 256 over 256 steps, with a repeated end point for interpolation
+static constexpr std::array<uint16_t, 257> make_breath_curve() {
+    std::array<uint16_t, 257> curve{};
+    for (int i = 0; i <= 256; i++) {
+        double level = (1 - dsp_tables_detail::cos(2 * dsp_tables_detail::pi * i / 256)) / 2;
+        curve[i] = static_cast<uint16_t>(level * 256 + 0.5);
+    }
+    return curve;
+}
+static constexpr std::array<uint16_t, 257> breath_curve = make_breath_curve();
+
+// Well mixed 32-bit hash, so neighbouring LEDs and periods look unrelated
+static inline uint32_t hash32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7FEB352D;
+    x ^= x >> 15;
+    x *= 0x846CA68B;
+    x ^= x >> 16;
+    return x;
+}
+
+// Position of `now` within a repeating `period`, from 0 to 65535
+static inline uint32_t phase_q16(effect_time_t now, effect_time_t period) {
+    return (uint32_t)(((uint64_t)(now % period) << 16) / period);
+}
+
+// Per channel combinations of two packed colours
+static inline uint32_t add_led_data(uint32_t below, uint32_t above) {
+    uint32_t result = 0;
+    for (int shift = 8; shift < 32; shift += 8) {
+        uint32_t sum = ((below >> shift) & 0xFF) + ((above >> shift) & 0xFF);
+        result |= (sum > 255 ? 255 : sum) << shift;
+    }
+    return result;
+}
+
+static inline uint32_t lighten_led_data(uint32_t below, uint32_t above) {
+    uint32_t result = 0;
+    for (int shift = 8; shift < 32; shift += 8) {
+        uint32_t mask = 0xFFu << shift;
+        result |= ((below & mask) > (above & mask)) ? (below & mask) : (above & mask);
+    }
+    return result;
+}
+
+static inline uint32_t multiply_led_data(uint32_t below, uint32_t above) {
+    uint32_t result = 0;
+    for (int shift = 8; shift < 32; shift += 8) {
+        uint32_t product = ((below >> shift) & 0xFF) * (((above >> shift) & 0xFF) + 1);
+        result |= (product >> 8) << shift;
+    }
+    return result;
+}
+
+effect_time_t effect_time_from_us(uint64_t us) {
+    return (effect_time_t)((us << 16) / 1000000);
+}
+
+effect_time_t effect_time_now() {
+    return effect_time_from_us(time_us_64());
+}
+
+// Chase
+chase_effect::chase_effect(colour colour, int length, int32_t speed, bool fade_tail)
+    : data(led_array::colour_to_led_data(colour)), length(length > 0 ? length : 1), speed(speed), fade_tail(fade_tail) {
+}
+
+void chase_effect::render(effect_time_t now, uint32_t frame[], int num_leds) const {
+    if (num_leds <= 0) {
+        return;
+    }
+    // Head position in Q16 LEDs, wrapped into the strip
+    int64_t strip_q16 = (int64_t)num_leds << 16;
+    int64_t head = ((int64_t)now * speed >> 16) % strip_q16;
+    head = (head < 0) ? head + strip_q16 : head;
+    uint32_t length_q16 = (uint32_t)length << 16;
+    uint32_t level_per_led = (255u << 8) / length; // Q8, so the tail fades without a division per LED
+
+    for (int i = 0; i < num_leds; i++) {
+        // Distance behind the head, in the direction of travel
+        int64_t behind = (speed >= 0) ? head - ((int64_t)i << 16) : ((int64_t)i << 16) - head;
+        behind = (behind < 0) ? behind + strip_q16 : behind;
+        if ((uint32_t)behind >= length_q16) {
+            frame[i] = 0;
+            continue;
+        }
+        uint32_t level = fade_tail ? 255 - (((uint32_t)behind >> 8) * level_per_led >> 16) : 255;
+        frame[i] = led_array::scale_led_data(data, level + 1);
+    }
+}
+
+// Breathe
+breathe_effect::breathe_effect(colour colour, effect_time_t period, uint8_t min_level)
+    : data(led_array::colour_to_led_data(colour)), period(period > 0 ? period : 1), min_level(min_level) {
+}
+
+void breathe_effect::render(effect_time_t now, uint32_t frame[], int num_leds) const {
+    uint32_t phase = phase_q16(now, period);
+    uint32_t index = phase >> 8;
+    uint32_t fraction = phase & 0xFF;
+    uint32_t curve = (breath_curve[index] * (256 - fraction) + breath_curve[index + 1] * fraction) >> 8; // 0 to 256
+    uint32_t level = min_level + ((curve * (256 - min_level)) >> 8);
+    uint32_t scaled = led_array::scale_led_data(data, level);
+    for (int i = 0; i < num_leds; i++) {
+        frame[i] = scaled;
+    }
+}
+
+// Rainbow
+rainbow_effect::rainbow_effect(int32_t speed, int spread, uint8_t saturation, uint8_t value)
+    : speed(speed), spread(spread), saturation(saturation), value(value) {
+}
+
+void rainbow_effect::render(effect_time_t now, uint32_t frame[], int num_leds) const {
+    if (num_leds <= 0) {
+        return;
+    }
+    // Work in Q8 hue steps so a short spread still moves smoothly along a long strip
+    uint32_t first_hue = (uint32_t)(((int64_t)now * speed) >> 16); // Turns in Q32, so 65536 per turn
+    int32_t hue_per_led = (spread << 8) / num_leds;
+    for (int i = 0; i < num_leds; i++) {
+        uint8_t hue = (uint8_t)((first_hue + (uint32_t)(hue_per_led * i)) >> 8);
+        frame[i] = led_array::colour_to_led_data(colour::from_hsv(hue, saturation, value));
+    }
+}
+
+// Sparkle
+sparkle_effect::sparkle_effect(colour colour, uint8_t density, effect_time_t period, uint32_t seed)
+    : data(led_array::colour_to_led_data(colour)), density(density), period(period > 0 ? period : 1), seed(seed) {
+}
+
+void sparkle_effect::render(effect_time_t now, uint32_t frame[], int num_leds) const {
+    uint32_t slot = now / period;
+    uint32_t position = phase_q16(now, period) >> 8; // 0 to 255 within the period
+    uint32_t slot_seed = hash32(slot ^ seed);
+    for (int i = 0; i < num_leds; i++) {
+        uint32_t h = hash32(slot_seed + i);
+        uint32_t start = (h >> 8) & 0x7F; // Flashes start in the first half of the period
+        if ((h & 0xFF) >= density || position < start) {
+            frame[i] = 0;
+            continue;
+        }
+        uint32_t age = position - start; // Fades out over half a period
+        uint32_t peak = 128 + ((h >> 16) & 0x7F);
+        frame[i] = (age < 128) ? led_array::scale_led_data(data, (peak * (128 - age)) >> 7) : 0;
+    }
+}
+
+// Gradient
+gradient_effect::gradient_effect(colour start, colour end, int32_t speed)
+    : start(led_array::colour_to_led_data(start)), end(led_array::colour_to_led_data(end)), speed(speed) {
+}
+
+void gradient_effect::render(effect_time_t now, uint32_t frame[], int num_leds) const {
+    if (num_leds <= 0) {
+        return;
+    }
+    if (speed == 0) {
+        uint32_t weight_per_led = (num_leds > 1) ? (256u << 16) / (num_leds - 1) : 0; // Q16
+        for (int i = 0; i < num_leds; i++) {
+            frame[i] = led_array::blend_led_data(start, end, (weight_per_led * i + 0x8000) >> 16);
+        }
+        return;
+    }
+    uint32_t offset = (uint32_t)(((int64_t)now * speed) >> 16); // Q16 strip lengths, wrapping
+    uint32_t step = EFFECT_Q16_ONE / num_leds;
+    for (int i = 0; i < num_leds; i++) {
+        uint32_t position = (offset + step * i) & 0xFFFF;
+        uint32_t weight = ((position < 0x8000) ? position : 0xFFFF - position) >> 7; // Out and back, 0 to 255
+        frame[i] = led_array::blend_led_data(start, end, weight);
+    }
+}
+
+// Constructor
+led_effects::led_effects(uint32_t *frame, uint32_t *layer_frame, int capacity)
+    : frame(frame), layer_frame(layer_frame), capacity(capacity), layers(), layer_count(0) {
+}
+
+int led_effects::add_layer(const led_effect &effect, effect_blend blend, uint8_t opacity) {
+    if (layer_count == LED_EFFECTS_MAX_LAYERS) {
+        return -1;
+    }
+    layers[layer_count] = {&effect, blend, opacity};
+    return layer_count++;
+}
+
+void led_effects::set_layer_opacity(int layer, uint8_t opacity) {
+    if (layer >= 0 && layer < layer_count) {
+        layers[layer].opacity = opacity;
+    }
+}
+
+void led_effects::clear_layers() {
+    layer_count = 0;
+}
+
+const uint32_t *led_effects::render(effect_time_t now, int num_leds) {
+    num_leds = (num_leds < capacity) ? num_leds : capacity;
+    memset(frame, 0, num_leds * sizeof(uint32_t));
+
+    for (int l = 0; l < layer_count; l++) {
+        const layer &current = layers[l];
+        uint32_t weight = current.opacity + (current.opacity >> 7); // 0 to 256
+        if (weight == 0) {
+            continue;
+        }
+        if (current.blend == effect_blend::over && weight == 256) {
+            current.effect->render(now, frame, num_leds); // Covers everything below, so draw straight into the frame
+            continue;
+        }
+
+        current.effect->render(now, layer_frame, num_leds);
+        for (int i = 0; i < num_leds; i++) {
+            uint32_t above = layer_frame[i];
+            switch (current.blend) {
+            case effect_blend::over:
+                frame[i] = led_array::blend_led_data(frame[i], above, weight);
+                break;
+            case effect_blend::add:
+                frame[i] = add_led_data(frame[i], led_array::scale_led_data(above, weight));
+                break;
+            case effect_blend::lighten:
+                frame[i] = lighten_led_data(frame[i], led_array::scale_led_data(above, weight));
+                break;
+            case effect_blend::multiply:
+                frame[i] = led_array::blend_led_data(frame[i], multiply_led_data(frame[i], above), weight);
+                break;
+            }
+        }
+    }
+    return frame;
+}
+
+void led_effects::render(effect_time_t now, led_array &leds) {
+    int num_leds = (leds.get_num_leds() < capacity) ? leds.get_num_leds() : capacity;
+    leds.begin_frame();
+    leds.set_packed_slice(0, render(now, num_leds), num_leds);
+    leds.commit_frame();
+}
+
+void led_effects::render(effect_time_t now, led_renderer &renderer, int num_leds) {
+    num_leds = (num_leds < capacity) ? num_leds : capacity;
+    renderer.set_packed_slice(0, render(now, num_leds), num_leds);
+    renderer.publish();
+}
@@ -0,0 +1,219 @@
+#ifndef LED_EFFECTS_H
+#define LED_EFFECTS_H
+
+#include <stdint.h>
+#include "colour.h"
+#include "led_array.h"
+#include "led_renderer.h"
+
+#define LED_EFFECTS_MAX_LAYERS 8 // Layers that can be stacked in one led_effects
+#define EFFECT_Q16_ONE 65536     // 1.0 in Q16.16
+
+/*! \brief A time in seconds as Q16.16 fixed point. Wraps after about 18 hours, which the effects allow for. */
+typedef uint32_t effect_time_t;
+
+/*! \brief Converts a time in microseconds, e.g. from `time_us_64()`, to an effect time. */
+effect_time_t effect_time_from_us(uint64_t us);
+
+/*! \brief Returns the current effect time, counted from boot. */
+effect_time_t effect_time_now();
+
+/*! \brief How a layer is combined with the layers below it. */
+enum class effect_blend {
+    over,     /*!< Cover the layers below, mixed in by the layer's opacity */
+    add,      /*!< Add the channels, saturating at full brightness */
+    lighten,  /*!< Keep the brighter of each channel */
+    multiply, /*!< Scale the layers below by the layer, so a white effect acts as a mask */
+};
+
+/*! \brief An animation that draws a frame for any given time.
+ *
+ * Effects hold only their parameters: every frame is computed from the time alone, in integer arithmetic, so effects
+ * can be shared between layers and strips and never drift.
+ */
+class led_effect {
+public:
+    virtual ~led_effect() = default;
+
+    /*! \brief Draws the effect at time `now`.
+     *
+     * \param now The time to draw.
+     * \param frame Receives one colour per LED, packed by `led_array::colour_to_led_data()`.
+     * \param num_leds The number of LEDs to draw.
+     */
+    virtual void render(effect_time_t now, uint32_t frame[], int num_leds) const = 0;
+};
+
+/*! \brief A block of lit LEDs running along the strip, optionally with a fading tail. */
+class chase_effect : public led_effect {
+public:
+    /*! \param colour Colour of the head.
+     *  \param length LEDs lit, including the head.
+     *  \param speed LEDs per second in Q16.16. Negative values run towards the start of the strip.
+     *  \param fade_tail Fade the block out behind the head instead of lighting it evenly.
+     */
+    chase_effect(colour colour, int length, int32_t speed, bool fade_tail);
+    void render(effect_time_t now, uint32_t frame[], int num_leds) const override;
+
+private:
+    uint32_t data;
+    int length;
+    int32_t speed;
+    bool fade_tail;
+};
+
+/*! \brief The whole strip fading smoothly up and down in one colour. */
+class breathe_effect : public led_effect {
+public:
+    /*! \param colour Colour at the top of each breath.
+     *  \param period Seconds per breath in Q16.16.
+     *  \param min_level Brightness at the bottom of each breath, 0 to 255.
+     */
+    breathe_effect(colour colour, effect_time_t period, uint8_t min_level);
+    void render(effect_time_t now, uint32_t frame[], int num_leds) const override;
+
+private:
+    uint32_t data;
+    effect_time_t period;
+    uint8_t min_level;
+};
+
+/*! \brief The colour wheel spread along the strip and turning over time. */
+class rainbow_effect : public led_effect {
+public:
+    /*! \param speed Turns of the colour wheel per second in Q16.16. Negative values turn the other way.
+     *  \param spread Hue change from one end of the strip to the other, 256 being the whole wheel.
+     *  \param saturation Saturation of every LED.
+     *  \param value Value of every LED.
+     */
+    rainbow_effect(int32_t speed, int spread, uint8_t saturation, uint8_t value);
+    void render(effect_time_t now, uint32_t frame[], int num_leds) const override;
+
+private:
+    int32_t speed;
+    int spread;
+    uint8_t saturation;
+    uint8_t value;
+};
+
+/*! \brief Random LEDs flashing and fading out.
+ *
+ * Time is split into flash periods. In each period an LED flashes with probability `density` / 256, starting in the
+ * first half of the period and fading out over half a period. The choice comes from a hash of the LED and the period,
+ * so no state is kept and the same time always gives the same frame.
+ */
+class sparkle_effect : public led_effect {
+public:
+    /*! \param colour Colour of each flash at full strength.
+     *  \param density Chance out of 256 that an LED flashes in each period.
+     *  \param period Seconds per flash period in Q16.16.
+     *  \param seed Picks a different pattern, e.g. for two sparkle layers.
+     */
+    sparkle_effect(colour colour, uint8_t density, effect_time_t period, uint32_t seed);
+    void render(effect_time_t now, uint32_t frame[], int num_leds) const override;
+
+private:
+    uint32_t data;
+    uint8_t density;
+    effect_time_t period;
+    uint32_t seed;
+};
+
+/*! \brief A blend between two colours along the strip.
+ *
+ * Still, it runs from `start` at the first LED to `end` at the last. Scrolling, it runs from `start` to `end` and back
+ * over the length of the strip so that it wraps around without a seam.
+ */
+class gradient_effect : public led_effect {
+public:
+    /*! \param start Colour at the start.
+     *  \param end Colour at the end.
+     *  \param speed Strip lengths per second in Q16.16, or 0 for a still gradient.
+     */
+    gradient_effect(colour start, colour end, int32_t speed);
+    void render(effect_time_t now, uint32_t frame[], int num_leds) const override;
+
+private:
+    uint32_t start;
+    uint32_t end;
+    int32_t speed;
+};
+
+/*! \brief A stack of effect layers composed into one frame.
+ *
+ * Layers are drawn bottom first, each combined with those below it by its blend mode and opacity, starting from black.
+ * The storage is provided by the derived class, normally `led_strip_effects<N>`.
+ */
+class led_effects {
+public:
+    led_effects(const led_effects &) = delete;
+    led_effects &operator=(const led_effects &) = delete;
+
+    /*! \brief Adds a layer on top of the stack.
+     *
+     * \param effect The effect to draw, which must stay alive while it is in the stack.
+     * \param blend How the layer is combined with the layers below.
+     * \param opacity Strength of the layer, 255 for full.
+     * \return The index of the layer, or -1 if the stack already holds `LED_EFFECTS_MAX_LAYERS` layers.
+     */
+    int add_layer(const led_effect &effect, effect_blend blend, uint8_t opacity);
+
+    /*! \brief Changes the opacity of a layer, e.g. to fade it in or out. Invalid indices are ignored. */
+    void set_layer_opacity(int layer, uint8_t opacity);
+
+    /*! \brief Removes every layer. */
+    void clear_layers();
+
+    /*! \brief Composes the layers at time `now` and returns the frame, packed like `led_array` colours.
+     *
+     * \param num_leds The number of LEDs to draw, at most the capacity of the stack.
+     */
+    const uint32_t *render(effect_time_t now, int num_leds);
+
+    /*! \brief Composes the layers at time `now` and sends them to an LED array as one frame. */
+    void render(effect_time_t now, led_array &leds);
+
+    /*! \brief Composes the layers at time `now` into a renderer's back buffer and publishes it. */
+    void render(effect_time_t now, led_renderer &renderer, int num_leds);
+
+protected:
+    /*! \brief Creates a stack that composes into storage owned by the derived class.
+     *
+     * \param frame Storage for the composed frame.
+     * \param layer_frame Storage for drawing one layer before it is combined.
+     * \param capacity The number of LEDs in each buffer.
+     */
+    led_effects(uint32_t *frame, uint32_t *layer_frame, int capacity);
+
+private:
+    struct layer {
+        const led_effect *effect;
+        effect_blend blend;
+        uint8_t opacity;
+    };
+
+    // Member variables
+    uint32_t *frame;                       // The composed frame
+    uint32_t *layer_frame;                 // One layer before it is combined
+    int capacity;                          // LEDs in each buffer
+    layer layers[LED_EFFECTS_MAX_LAYERS];  // Bottom layer first
+    int layer_count;
+};
+
+/*! \brief A stack of effect layers for exactly `STRIP_LEDS` LEDs, sized at compile time.
+ *
+ * \tparam STRIP_LEDS The number of LEDs on the strip.
+ */
+template <int STRIP_LEDS>
+class led_strip_effects : public led_effects {
+    static_assert(STRIP_LEDS > 0 && STRIP_LEDS <= LED_ARRAY_MAX_LEDS, "led_strip_effects needs 1 to LED_ARRAY_MAX_LEDS LEDs");
+
+public:
+    led_strip_effects() : led_effects(strip_frame, strip_layer_frame, STRIP_LEDS) {}
+
+private:
+    uint32_t strip_frame[STRIP_LEDS];       // The composed frame
+    uint32_t strip_layer_frame[STRIP_LEDS]; // One layer before it is combined
+};
+
+#endif // LED_EFFECTS_H
@@ -0,0 +1,158 @@
+#include <string.h>
+#include "led_renderer.h"
+#include "pico/stdlib.h"
+
+// Constructor
+led_renderer::led_renderer(uint32_t *frames, uint32_t *fade_from, int capacity)
+    : frames(frames), fade_from(fade_from), capacity(capacity), num_leds(0), leds(nullptr), timer(), fade_frames(0),
+      fade_position(0), back(0), target(1) {
+}
+
+// Destructor
+led_renderer::~led_renderer() {
+    stop();
+}
+
+bool led_renderer::start(led_array &leds, int fps, int fade_frames) {
+    stop();
+    num_leds = (leds.get_num_leds() < capacity) ? leds.get_num_leds() : capacity;
+    this->fade_frames = (fade_frames > 1) ? fade_frames : 1;
+    fade_position = this->fade_frames;
+    stats = led_renderer_stats();
+
+    // Start every frame from what the strip shows now
+    for (uint8_t i = 0; i < LED_RENDERER_FRAME_COUNT; i++) {
+        memcpy(frame(i), leds.led_data, num_leds * sizeof(uint32_t));
+    }
+    memcpy(fade_from, leds.led_data, num_leds * sizeof(uint32_t));
+    back = 0;
+    target = 1;
+    published_frames.clear();
+    free_frames.clear();
+    for (uint8_t i = 2; i < LED_RENDERER_FRAME_COUNT; i++) {
+        free_frames.push(i);
+    }
+
+    this->leds = &leds;
+    int64_t period_us = 1000000 / (fps > 0 ? fps : 1);
+    if (!add_repeating_timer_us(-period_us, on_tick, this, &timer)) { // Negative: measured between tick starts
+        this->leds = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void led_renderer::stop() {
+    if (leds == nullptr) {
+        return;
+    }
+    cancel_repeating_timer(&timer);
+    leds->wait_until_ready();
+    leds = nullptr;
+}
+
+void led_renderer::set_colour_individual(int index, colour colour) {
+    if (index >= 0 && index < num_leds) {
+        frame(back)[index] = led_array::colour_to_led_data(colour);
+    }
+}
+
+void led_renderer::fill_slice(int start, int count, colour colour) {
+    if (count <= 0 || num_leds == 0) {
+        return;
+    }
+    uint32_t data = led_array::colour_to_led_data(colour);
+    uint32_t *back_frame = frame(back);
+    if (count > num_leds) {
+        count = num_leds;
+    }
+    int index = start % num_leds;
+    index = (index < 0) ? index + num_leds : index;
+    for (int i = 0; i < count; i++) {
+        back_frame[index] = data;
+        index = (index + 1 == num_leds) ? 0 : index + 1;
+    }
+}
+
+void led_renderer::set_packed_slice(int start, const uint32_t data[], int count) {
+    if (count <= 0 || num_leds == 0) {
+        return;
+    }
+    uint32_t *back_frame = frame(back);
+    if (count > num_leds) {
+        count = num_leds;
+    }
+    int index = start % num_leds;
+    index = (index < 0) ? index + num_leds : index;
+    for (int i = 0; i < count; i++) {
+        back_frame[index] = data[i];
+        index = (index + 1 == num_leds) ? 0 : index + 1;
+    }
+}
+
+void led_renderer::clear_all() {
+    memset(frame(back), 0, num_leds * sizeof(uint32_t));
+}
+
+bool led_renderer::publish() {
+    uint8_t next;
+    if (!free_frames.pop(next)) {
+        stats.frames_dropped = stats.frames_dropped + 1;
+        return false;
+    }
+    memcpy(frame(next), frame(back), num_leds * sizeof(uint32_t)); // Keep drawing on top of the published frame
+    published_frames.push(back);
+    back = next;
+    stats.frames_published = stats.frames_published + 1;
+    return true;
+}
+
+const led_renderer_stats &led_renderer::get_stats() const {
+    return stats;
+}
+
+uint32_t *led_renderer::frame(uint8_t index) const {
+    return &frames[index * capacity];
+}
+
+bool led_renderer::on_tick(repeating_timer_t *timer) {
+    static_cast<led_renderer *>(timer->user_data)->present();
+    return true; // Keep ticking until stop()
+}
+
+// Runs in the timer interrupt, so it never waits for the strip
+void led_renderer::present() {
+    stats.ticks = stats.ticks + 1;
+    if (leds->is_busy()) {
+        stats.ticks_late = stats.ticks_late + 1;
+        return;
+    }
+
+    // Take the newest published frame and hand any older ones straight back
+    uint8_t index;
+    int newest = -1;
+    while (published_frames.pop(index)) {
+        if (newest >= 0) {
+            free_frames.push(static_cast<uint8_t>(newest));
+        }
+        newest = index;
+    }
+    if (newest >= 0) {
+        // Fade from whatever is on the strip, so a frame arriving part way through a fade does not jump
+        memcpy(fade_from, leds->led_data, num_leds * sizeof(uint32_t));
+        free_frames.push(target);
+        target = static_cast<uint8_t>(newest);
+        fade_position = 0;
+    }
+
+    if (fade_position < fade_frames) {
+        fade_position++;
+    }
+    uint32_t weight = (fade_position * 256) / fade_frames;
+    const uint32_t *target_frame = frame(target);
+    leds->begin_frame();
+    for (int i = 0; i < num_leds; i++) {
+        leds->write_led(i, (weight == 256) ? target_frame[i] : led_array::blend_led_data(fade_from[i], target_frame[i], weight));
+    }
+    leds->commit_frame(); // Only sends the strip while something is changing
+}
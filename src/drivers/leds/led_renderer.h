@@ -0,0 +1,125 @@
+#ifndef LED_RENDERER_H
+#define LED_RENDERER_H
+
+#include "led_array.h"
+#include "pico/time.h"
+#include "utils/spsc_queue.h"
+
+#define LED_RENDERER_FRAME_COUNT 4 // Producer's back buffer, the frame on show, and two in flight between them
+
+/*! \brief Counters describing how a renderer is keeping up. */
+struct led_renderer_stats {
+    volatile uint32_t frames_published = 0; /*!< Frames handed over by `publish()` */
+    volatile uint32_t frames_dropped = 0;   /*!< `publish()` calls refused because the renderer had not caught up */
+    volatile uint32_t ticks = 0;            /*!< Timer ticks, one per displayed frame */
+    volatile uint32_t ticks_late = 0;       /*!< Ticks skipped because the strip was still sending the last frame */
+};
+
+/*! \brief Shows frames on an LED array at a fixed frame rate, cross-fading between the frames a producer publishes.
+ *
+ * The producer draws into a back buffer with the setters and calls `publish()` whenever a frame is complete, at any
+ * rate and from either core. A repeating hardware timer presents a frame on every tick: it picks up the newest
+ * published frame and fades towards it over a set number of ticks, so the strip refreshes smoothly however irregular
+ * the producer is. Frames are handed over through `spsc_queue`s of buffer indices, so neither side blocks.
+ *
+ * The storage is provided by the derived class, normally `led_strip_renderer<N>`. While running, the renderer is the
+ * only user of the LED array.
+ */
+class led_renderer {
+public:
+    /*! \brief Stops the renderer if it is running. */
+    ~led_renderer();
+
+    led_renderer(const led_renderer &) = delete;
+    led_renderer &operator=(const led_renderer &) = delete;
+
+    /*! \brief Starts presenting frames on an initialised LED array.
+     *
+     * Every buffer starts as a copy of what the strip shows now, so starting does not change the LEDs.
+     *
+     * \param leds The LED array, which must stay alive until `stop()`. Only the first LEDs are used if it is longer
+     *             than the renderer.
+     * \param fps Frames presented per second.
+     * \param fade_frames Ticks over which to fade to a newly published frame. 0 or 1 shows each frame straight away.
+     * \return false if no timer was available.
+     */
+    bool start(led_array &leds, int fps, int fade_frames);
+
+    /*! \brief Stops the timer and waits for the last frame to reach the LEDs. */
+    void stop();
+
+    /*! \brief Sets the colour of one LED in the back buffer. Out of range indices are ignored. */
+    void set_colour_individual(int index, colour colour);
+
+    /*! \brief Sets `count` consecutive LEDs of the back buffer from `start`, wrapping like `led_array::fill_slice()`. */
+    void fill_slice(int start, int count, colour colour);
+
+    /*! \brief Copies packed colours into the back buffer from `start`, like `led_array::set_packed_slice()`. */
+    void set_packed_slice(int start, const uint32_t data[], int count);
+
+    /*! \brief Sets every LED in the back buffer to black. */
+    void clear_all();
+
+    /*! \brief Hands the back buffer to the renderer as the newest frame.
+     *
+     * The back buffer keeps its contents, so the next frame can be drawn as changes to this one.
+     *
+     * \return false if the renderer has not yet taken the last two frames, in which case the frame stays in the back
+     *         buffer and is not shown until a later `publish()` succeeds.
+     */
+    bool publish();
+
+    /*! \brief Returns counters for tuning the frame rate and the producer. */
+    const led_renderer_stats &get_stats() const;
+
+protected:
+    /*! \brief Creates a renderer that keeps its frames in storage owned by the derived class.
+     *
+     * \param frames Storage for `LED_RENDERER_FRAME_COUNT` frames of `capacity` words, one after the other.
+     * \param fade_from Storage for one frame, the start of the current fade.
+     * \param capacity The number of LEDs in each frame.
+     */
+    led_renderer(uint32_t *frames, uint32_t *fade_from, int capacity);
+
+private:
+    /*! \brief Returns the frame with the given index. */
+    uint32_t *frame(uint8_t index) const;
+
+    /*! \brief Picks up the newest frame and sends the next step of the fade to the strip. */
+    void present();
+
+    static bool on_tick(repeating_timer_t *timer);
+
+    // Member variables
+    uint32_t *frames;                         // LED_RENDERER_FRAME_COUNT frames in led_array data format
+    uint32_t *fade_from;                      // What the strip showed when the current fade started
+    int capacity;                             // LEDs in each frame
+    int num_leds;                             // LEDs in use, at most `capacity`
+    led_array *leds;                          // The strip being driven, or null when stopped
+    repeating_timer_t timer;                  // Presents a frame on every tick
+    int fade_frames;                          // Ticks per fade
+    int fade_position;                        // Ticks into the current fade
+    uint8_t back;                             // Frame being drawn by the producer
+    uint8_t target;                           // Frame being faded to, owned by the timer
+    spsc_queue<uint8_t, 2> published_frames;  // Producer to timer: frames to show, oldest first
+    spsc_queue<uint8_t, 2> free_frames;       // Timer to producer: frames that can be drawn into
+    led_renderer_stats stats;
+};
+
+/*! \brief A renderer with frames for exactly `STRIP_LEDS` LEDs, sized at compile time.
+ *
+ * \tparam STRIP_LEDS The number of LEDs on the strip.
+ */
+template <int STRIP_LEDS>
+class led_strip_renderer : public led_renderer {
+    static_assert(STRIP_LEDS > 0 && STRIP_LEDS <= LED_ARRAY_MAX_LEDS, "led_strip_renderer needs 1 to LED_ARRAY_MAX_LEDS LEDs");
+
+public:
+    led_strip_renderer() : led_renderer(strip_frames, strip_fade_from, STRIP_LEDS) {}
+
+private:
+    uint32_t strip_frames[LED_RENDERER_FRAME_COUNT * STRIP_LEDS]; // Back buffer, target and frames in flight
+    uint32_t strip_fade_from[STRIP_LEDS];                         // Start of the current fade
+};
+
+#endif // LED_RENDERER_H
@@ -0,0 +1,30 @@
+#ifndef LED_STRIP_H
+#define LED_STRIP_H
+
+#include "led_array.h"
+
+/*! \brief An LED array with storage for exactly `STRIP_LEDS` LEDs, sized at compile time.
+ *
+ * \tparam STRIP_LEDS The number of LEDs on the strip.
+ */
+template <int STRIP_LEDS>
+class led_strip : public led_array {
+    static_assert(STRIP_LEDS > 0 && STRIP_LEDS <= LED_ARRAY_MAX_LEDS, "led_strip needs 1 to LED_ARRAY_MAX_LEDS LEDs");
+
+public:
+    led_strip() : led_array(strip_data, strip_tx_buffer, STRIP_LEDS) {}
+
+    using led_array::init;
+
+    /*! \brief Initialises every LED of the strip on the given pin.
+     *
+     * \param pin The GPIO pin used to control the strip.
+     */
+    void init(uint pin) { led_array::init(pin, STRIP_LEDS); }
+
+private:
+    uint32_t strip_data[STRIP_LEDS];      // Colour of each LED
+    uint32_t strip_tx_buffer[STRIP_LEDS]; // Copy being read by the DMA
+};
+
+#endif // LED_STRIP_H
@@ -0,0 +1,89 @@
+#include "led_strip_manager.h"
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "WS2812.pio.h"
+
+#define LED_STRIP_FREQUENCY_HZ 800000
+
+int led_strip_manager::program_offsets[NUM_PIOS] = {-1, -1};
+
+// Constructor
+led_strip_manager::led_strip_manager()
+    : strips{}, strip_count(0) {
+}
+
+bool led_strip_manager::add_strip(led_array &strip) {
+    if (strip_count == LED_ARRAY_MAX_STRIPS) {
+        return false;
+    }
+    strips[strip_count++] = &strip;
+    return true;
+}
+
+void led_strip_manager::begin_frame() {
+    for (int i = 0; i < strip_count; i++) {
+        strips[i]->begin_frame();
+    }
+}
+
+int led_strip_manager::commit_frame() {
+    // Arm every changed strip first, then start their DMA channels together
+    uint32_t channel_mask = 0;
+    int strips_sent = 0;
+    for (int i = 0; i < strip_count; i++) {
+        led_array *strip = strips[i];
+        strip->frame_open = false;
+        if (!strip->dirty) {
+            continue;
+        }
+        strip->dirty = false;
+        if (!strip->frame_changed()) {
+            continue;
+        }
+        strip->prepare_show();
+        channel_mask |= 1u << strip->dma_channel;
+        strips_sent++;
+    }
+    if (channel_mask != 0) {
+        dma_start_channel_mask(channel_mask);
+    }
+    return strips_sent;
+}
+
+bool led_strip_manager::is_busy() const {
+    for (int i = 0; i < strip_count; i++) {
+        if (strips[i]->is_busy()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void led_strip_manager::wait_until_ready() const {
+    for (int i = 0; i < strip_count; i++) {
+        strips[i]->wait_until_ready();
+    }
+}
+
+bool led_strip_manager::claim_output(uint pin, PIO &pio, uint &sm) {
+    PIO blocks[NUM_PIOS] = {pio0, pio1};
+    for (int i = 0; i < NUM_PIOS; i++) {
+        int claimed = pio_claim_unused_sm(blocks[i], false);
+        if (claimed < 0) {
+            continue;
+        }
+        if (program_offsets[i] < 0) {
+            program_offsets[i] = pio_add_program(blocks[i], &ws2812_program); // Only ever loaded once per PIO
+        }
+        pio = blocks[i];
+        sm = claimed;
+        ws2812_program_init(pio, sm, program_offsets[i], pin, LED_STRIP_FREQUENCY_HZ, false);
+        return true;
+    }
+    return false;
+}
+
+void led_strip_manager::release_output(PIO pio, uint sm) {
+    pio_sm_set_enabled(pio, sm, false);
+    pio_sm_unclaim(pio, sm);
+}
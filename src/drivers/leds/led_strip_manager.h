@@ -0,0 +1,63 @@
+#ifndef LED_STRIP_MANAGER_H
+#define LED_STRIP_MANAGER_H
+
+#include "led_array.h"
+#include "hardware/pio.h"
+
+/*! \brief Owns the PIO resources shared by every LED strip, and refreshes groups of strips in parallel.
+ *
+ * The ws2812 program is loaded into each PIO the first time a strip needs it and then reused, so restarting tasks no
+ * longer uses up PIO instruction memory. Strips are spread over the state machines of `pio0` and then `pio1`, up to
+ * `LED_ARRAY_MAX_STRIPS` at once.
+ *
+ * Each strip has its own state machine and DMA channel, so a group of strips can be started with a single DMA
+ * trigger and the whole group refreshes in the time of its longest strip.
+ */
+class led_strip_manager {
+public:
+    // Constructor
+    led_strip_manager();
+
+    /*! \brief Adds an initialised strip to the group.
+     *
+     * \param strip The strip, which must stay alive for as long as the group is used.
+     * \return false if the group already holds `LED_ARRAY_MAX_STRIPS` strips.
+     */
+    bool add_strip(led_array &strip);
+
+    /*! \brief Starts a frame on every strip in the group. See `led_array::begin_frame()`. */
+    void begin_frame();
+
+    /*! \brief Ends the frame on every strip and sends all the strips that differ from their last frame at the same
+     * time.
+     *
+     * \return The number of strips sent.
+     */
+    int commit_frame();
+
+    /*! \brief Returns true while any strip in the group is being sent or latched. */
+    bool is_busy() const;
+
+    /*! \brief Blocks until every strip in the group has latched its last frame. */
+    void wait_until_ready() const;
+
+    /*! \brief Claims a free state machine and starts the ws2812 program on it, loading the program if needed.
+     *
+     * \param pin The GPIO pin the strip is connected to.
+     * \param pio Receives the PIO block that was claimed.
+     * \param sm Receives the state machine that was claimed.
+     * \return false if every state machine on both PIO blocks is in use.
+     */
+    static bool claim_output(uint pin, PIO &pio, uint &sm);
+
+    /*! \brief Stops and frees a state machine claimed by `claim_output()`. The program stays loaded for reuse. */
+    static void release_output(PIO pio, uint sm);
+
+private:
+    led_array *strips[LED_ARRAY_MAX_STRIPS]; // Strips in the group
+    int strip_count;
+
+    static int program_offsets[NUM_PIOS]; // Where the ws2812 program is loaded in each PIO, or -1
+};
+
+#endif // LED_STRIP_MANAGER_H
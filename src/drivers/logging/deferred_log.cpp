@@ -0,0 +1,116 @@
+#include "deferred_log.h"
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "hardware/uart.h"
+#include "utils/spsc_queue.h"
+
+// Each core has its own buffer, so the cores never contend. The queue takes a single producer, which interrupts on
+// that core are masked to provide; log_drain() is the only consumer.
+static spsc_queue<log_record, DEFERRED_LOG_DEPTH> pending[DEFERRED_LOG_CORES];
+static volatile uint32_t dropped[DEFERRED_LOG_CORES]; // Written by each core's producers
+static uint8_t sequence[DEFERRED_LOG_CORES];          // Written by each core's producers
+static uint32_t dropped_reported[DEFERRED_LOG_CORES]; // Written by log_drain()
+
+// The frame being sent, which may take several calls of log_drain() while the UART is busy
+static uint8_t frame[LOG_FRAME_SIZE];
+static size_t frame_sent = LOG_FRAME_SIZE;
+
+void log_deferred(log_id id, uint32_t arg0, uint32_t arg1, uint32_t arg2)
+{
+    if (log_message_levels[(size_t)id] < getLogLevel())
+    {
+        return;
+    }
+    uint core = get_core_num();
+    uint32_t time_us = time_us_32();
+
+    uint32_t interrupts = save_and_disable_interrupts(); // A handler on this core could log in the middle of this
+    log_record *record = pending[core].begin_push();
+    if (record == nullptr)
+    {
+        dropped[core] = dropped[core] + 1;
+    }
+    else
+    {
+        record->time_us = time_us;
+        record->id = (uint16_t)id;
+        record->core = (uint8_t)core;
+        record->sequence = sequence[core]++;
+        record->args[0] = arg0;
+        record->args[1] = arg1;
+        record->args[2] = arg2;
+        pending[core].end_push();
+    }
+    restore_interrupts(interrupts);
+}
+
+static void frame_record(const log_record &record)
+{
+    frame[0] = LOG_FRAME_SYNC_0;
+    frame[1] = LOG_FRAME_SYNC_1;
+    memcpy(&frame[2], &record, sizeof(record));
+    frame[LOG_FRAME_SIZE - 1] = log_frame_checksum(&frame[2], sizeof(record));
+    frame_sent = 0;
+}
+
+// Frame the next thing to send: a report of records dropped since the last one, or else the oldest waiting record
+// from either core. Returns false if there is nothing to send.
+static bool frame_next()
+{
+    for (uint core = 0; core < DEFERRED_LOG_CORES; core++)
+    {
+        uint32_t lost = dropped[core] - dropped_reported[core];
+        if (lost != 0)
+        {
+            dropped_reported[core] += lost;
+            log_record report = {time_us_32(), (uint16_t)log_id::log_records_dropped, (uint8_t)core, 0, {lost, core, 0}};
+            frame_record(report);
+            return true;
+        }
+    }
+
+    log_record *oldest = nullptr;
+    uint oldest_core = 0;
+    for (uint core = 0; core < DEFERRED_LOG_CORES; core++)
+    {
+        log_record *record = pending[core].front();
+        // Compared by difference so that the order survives the timer wrapping
+        if (record != nullptr && (oldest == nullptr || (int32_t)(record->time_us - oldest->time_us) < 0))
+        {
+            oldest = record;
+            oldest_core = core;
+        }
+    }
+    if (oldest == nullptr)
+    {
+        return false;
+    }
+    frame_record(*oldest);
+    pending[oldest_core].pop();
+    return true;
+}
+
+size_t log_drain()
+{
+    size_t records_sent = 0;
+    for (;;)
+    {
+        while (frame_sent < LOG_FRAME_SIZE)
+        {
+            if (!uart_is_writable(DEFERRED_LOG_UART))
+            {
+                return records_sent; // The FIFO is full, so carry on from here next time rather than wait
+            }
+            uart_putc_raw(DEFERRED_LOG_UART, (char)frame[frame_sent++]);
+            if (frame_sent == LOG_FRAME_SIZE)
+            {
+                records_sent++;
+            }
+        }
+        if (!frame_next())
+        {
+            return records_sent;
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef DEFERRED_LOG_H
+#define DEFERRED_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "log_messages.h"
+
+#define DEFERRED_LOG_DEPTH 64   // Records waiting on each core, a power of two
+#define DEFERRED_LOG_CORES 2
+#define DEFERRED_LOG_UART uart0 // The stdio UART, so one capture holds both the text and the records
+
+/*! \brief Records a message to be sent later by `log_drain()`.
+ *
+ * Only the message ID, the time and the raw arguments are stored, in a RAM buffer for the calling core, so a call
+ * takes a fraction of a microsecond where `log()` waits for a whole line to go out over the UART. It is safe to call
+ * from either core and from interrupt handlers: interrupts on the calling core are masked only while the record is
+ * copied in. If the core's buffer is full the message is dropped, and the next `log_drain()` reports how many were lost.
+ *
+ * Messages below the level set with `setLogLevel()` are discarded straight away.
+ *
+ * \param id The message, from `LOG_MESSAGES`.
+ * \param arg0, arg1, arg2 Arguments for its format string. Signed values may be passed as they are.
+ */
+void log_deferred(log_id id, uint32_t arg0 = 0, uint32_t arg1 = 0, uint32_t arg2 = 0);
+
+/*! \brief Sends recorded messages, oldest first, as binary frames on `DEFERRED_LOG_UART`.
+ *
+ * Only writes while the UART's transmit FIFO has room and never waits for it, so it can be called in every pass of a
+ * real-time loop. A frame that does not fit is finished on a later call. Call it from one place only, such as the main
+ * loop or a loop on core 1. The host tool `log_decode` turns the frames back into text.
+ *
+ * \return The number of records sent completely.
+ */
+size_t log_drain();
+
+#endif // DEFERRED_LOG_H
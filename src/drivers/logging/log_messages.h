@@ -0,0 +1,76 @@
+#ifndef LOG_MESSAGES_H
+#define LOG_MESSAGES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "logging.h"
+
+#define LOG_MAX_ARGS 3 // Arguments recorded with each message
+
+/*! \brief Every message the deferred logger can record, as X(name, level, format).
+ *
+ * The board only records a message's ID and raw arguments. The format strings are used by the host decoder, so
+ * nothing is formatted on the board. Arguments are recorded as 32-bit words, so formats may only use the integer
+ * conversions %d, %u and %x, with flags and widths. Add new messages at the end, so that captures from older firmware
+ * still decode.
+ */
+#define LOG_MESSAGES(X)                                                                                 \
+    X(log_records_dropped, WARNING, "%u deferred log records dropped on core %u, buffer full")          \
+    X(task_switched, INFORMATION, "Switched to task %d in %u us (longest %u us)")                       \
+    X(events_waited, INFORMATION, "Events wait at most %u us, %u dropped")                              \
+    X(accel_reading, INFORMATION, "X: %d mg, Y: %d mg, Z: %d mg")                                        \
+    X(mic_frame_queue_full, WARNING, "Frame queue full after %u frames, core 1 has analysed %u")
+
+/*! \brief Compile-time IDs of the messages in `LOG_MESSAGES`. */
+enum class log_id : uint16_t
+{
+#define LOG_MESSAGE_ID(name, level, format) name,
+    LOG_MESSAGES(LOG_MESSAGE_ID)
+#undef LOG_MESSAGE_ID
+    count
+};
+
+/*! \brief Level of each message, indexed by `log_id`. */
+static constexpr LogLevel log_message_levels[] = {
+#define LOG_MESSAGE_LEVEL(name, level, format) LogLevel::level,
+    LOG_MESSAGES(LOG_MESSAGE_LEVEL)
+#undef LOG_MESSAGE_LEVEL
+};
+
+/*! \brief Format string of each message, indexed by `log_id`. Only the decoder needs these. */
+static constexpr const char *log_message_formats[] = {
+#define LOG_MESSAGE_FORMAT(name, level, format) format,
+    LOG_MESSAGES(LOG_MESSAGE_FORMAT)
+#undef LOG_MESSAGE_FORMAT
+};
+
+/*! \brief One recorded message. It is sent byte for byte, and both the RP2040 and the host are little-endian. */
+struct log_record
+{
+    uint32_t time_us;            /*!< `time_us_32()` when recorded */
+    uint16_t id;                 /*!< A `log_id` */
+    uint8_t core;                /*!< The core that recorded it */
+    uint8_t sequence;            /*!< Counts each core's records, so the decoder can tell if frames were lost */
+    uint32_t args[LOG_MAX_ARGS];
+};
+
+static_assert(sizeof(log_record) == 20, "log_record is sent as-is, so it must have no padding");
+
+// A record on the wire: two sync bytes, the record, then a checksum. The sync bytes let the decoder find frames among
+// ordinary text on the same UART, and the checksum rejects text that happens to start with them.
+#define LOG_FRAME_SYNC_0 0xA5
+#define LOG_FRAME_SYNC_1 0x5A
+#define LOG_FRAME_SIZE (2 + sizeof(log_record) + 1)
+
+/*! \brief Returns the checksum of a framed record: the sum of its bytes, inverted so that a run of zeros fails. */
+inline uint8_t log_frame_checksum(const uint8_t *record_bytes, size_t length)
+{
+    uint8_t sum = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        sum += record_bytes[i];
+    }
+    return (uint8_t)~sum;
+}
+
+#endif // LOG_MESSAGES_H
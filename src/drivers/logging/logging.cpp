@@ -16,6 +16,11 @@ void setLogLevel(LogLevel newLevel)
     maxLogLevel = newLevel;
 }
 
+LogLevel getLogLevel()
+{
+    return maxLogLevel;
+}
+
 void log(LogLevel level, const char *msg)
 {
     // Should we show this message?
@@ -10,5 +10,8 @@ enum LogLevel {
 /// Set the log level. Messages with a level below this threshold will be discarded.
 void setLogLevel(LogLevel newLevel);
 
+/// Get the current log level.
+LogLevel getLogLevel();
+
 /// Log a new message.
 void log(LogLevel level, const char *msg);
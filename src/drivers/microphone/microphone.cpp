@@ -1,10 +1,18 @@
 #include "microphone.h"
 #include <stdio.h>
+#include <string.h>
+#include "hardware/dma.h"
+#include "hardware/irq.h"
 #define DC_OFFSET 2048
+#define MICROPHONE_DMA_IRQ DMA_IRQ_0
+
+microphone *microphone::streaming_instance = nullptr;
 
 // Constructor
 microphone::microphone()
-    : gpio_pin(26) {}
+    : gpio_pin(26), dma_channels{-1, -1}, channel_buffer_index{0, 0}, stream_buffers(nullptr), stream_buffer_count(0),
+      stream_buffer_size(0), stream_callback(nullptr), buffers_filled(0), buffers_consumed(0), buffers_dropped(0),
+      events(nullptr) {}
 
 /*! \brief Initialize the microphone by setting up the ADC.
  *
@@ -23,7 +31,7 @@ void microphone::init(uint gpio_pin)
     // Initialize ADC
     adc_init();
     adc_select_input(0); // Channel 0 corresponds to GPIO26
-    adc_set_clkdiv(1087);
+    adc_set_clkdiv(MICROPHONE_ADC_CLOCK_DIVIDER);
     adc_fifo_setup( // Enable the ADC FIFO (without DMA)
         true,       // Write each completed conversion to the sample FIFO
         false,      // Disable DMA data request (DREQ)
@@ -68,3 +76,228 @@ void microphone::remove_offset_and_scale(int16_t *microphone_data, size_t buffer
         microphone_data[i] = (int16_t)(microphone_data[i] << 5); // Left shift by 5 to scale into Q15 range
     }
 }
+
+void microphone::preprocess_frame_reference(int16_t *microphone_data, const int16_t *window, size_t buffer_size)
+{
+    for (size_t i = 0; i < buffer_size; ++i)
+    {
+        int16_t scaled = (int16_t)((microphone_data[i] - DC_OFFSET) << 5); // Same wrap-around as the two-pass version
+        microphone_data[i] = ((int32_t)scaled * (int32_t)window[i]) >> 15;
+    }
+}
+
+// Offset, scale and window the two samples packed in one little-endian word, returning the packed results.
+// Each sample is isolated in the top half of a register before shifting so that it wraps at 16 bits exactly like the
+// int16_t arithmetic of the reference version, and the arithmetic shift back down sign-extends it for the multiply.
+static inline uint32_t preprocess_sample_pair(uint32_t samples, uint32_t coefficients)
+{
+    int32_t low = (int32_t)(((samples << 16) - ((uint32_t)DC_OFFSET << 16)) << 5) >> 16;
+    int32_t high = (int32_t)(((samples & 0xFFFF0000u) - ((uint32_t)DC_OFFSET << 16)) << 5) >> 16;
+    int32_t low_windowed = (low * (int32_t)(int16_t)coefficients) >> 15;
+    int32_t high_windowed = (high * ((int32_t)coefficients >> 16)) >> 15;
+    return ((uint32_t)low_windowed & 0xFFFF) | ((uint32_t)high_windowed << 16);
+}
+
+void microphone::preprocess_frame(int16_t *microphone_data, const int16_t *window, size_t buffer_size)
+{
+    if ((((uintptr_t)microphone_data) | ((uintptr_t)window)) & 3)
+    {
+        preprocess_frame_reference(microphone_data, window, buffer_size);
+        return;
+    }
+
+    // Word pointers, so each load or store moves two samples. memcpy of an aligned word compiles to a single ldr/str
+    // without breaking the aliasing rules.
+    uint8_t *data_words = (uint8_t *)__builtin_assume_aligned(microphone_data, 4);
+    const uint8_t *window_words = (const uint8_t *)__builtin_assume_aligned(window, 4);
+
+    // Main loop: four samples (two words) per iteration
+    size_t i = 0;
+    for (; i + 4 <= buffer_size; i += 4)
+    {
+        uint32_t samples_0, samples_1, coefficients_0, coefficients_1;
+        memcpy(&samples_0, data_words + i * 2, 4);
+        memcpy(&samples_1, data_words + i * 2 + 4, 4);
+        memcpy(&coefficients_0, window_words + i * 2, 4);
+        memcpy(&coefficients_1, window_words + i * 2 + 4, 4);
+
+        samples_0 = preprocess_sample_pair(samples_0, coefficients_0);
+        samples_1 = preprocess_sample_pair(samples_1, coefficients_1);
+
+        memcpy(data_words + i * 2, &samples_0, 4);
+        memcpy(data_words + i * 2 + 4, &samples_1, 4);
+    }
+
+    // Up to three leftover samples
+    preprocess_frame_reference(&microphone_data[i], &window[i], buffer_size - i);
+}
+
+/*! \brief Start gap-free streaming capture into a ring of buffers.
+ *
+ * Two DMA channels are chained to each other so that the moment one finishes its buffer the other starts on the
+ * next, without waiting for software. When a channel completes, its interrupt re-points it at the buffer after the
+ * one its partner is now filling, ready for the next hand-over.
+ */
+void microphone::start_streaming(int16_t *buffers, size_t buffer_count, size_t buffer_size,
+                                 microphone_buffer_callback_t callback)
+{
+    stream_buffers = buffers;
+    stream_buffer_count = buffer_count;
+    stream_buffer_size = buffer_size;
+    stream_callback = callback;
+    buffers_filled = 0;
+    buffers_consumed = 0;
+    buffers_dropped = 0;
+
+    adc_run(false);
+    adc_fifo_drain();
+    adc_fifo_setup( // Enable the ADC FIFO with DMA
+        true,       // Write each completed conversion to the sample FIFO
+        true,       // Enable DMA data request (DREQ)
+        1,          // Request a transfer as soon as one sample is present
+        false,      // Disable error bits
+        false       // Keep the full 12-bit results
+    );
+
+    dma_channels[0] = dma_claim_unused_channel(true);
+    dma_channels[1] = dma_claim_unused_channel(true);
+    for (int i = 0; i < 2; ++i)
+    {
+        dma_channel_config config = dma_channel_get_default_config(dma_channels[i]);
+        channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+        channel_config_set_read_increment(&config, false); // Always read the ADC FIFO
+        channel_config_set_write_increment(&config, true);
+        channel_config_set_dreq(&config, DREQ_ADC);
+        channel_config_set_chain_to(&config, dma_channels[1 - i]); // Hand over to the other channel when done
+
+        channel_buffer_index[i] = i;
+        dma_channel_configure(dma_channels[i], &config, &stream_buffers[i * stream_buffer_size], &adc_hw->fifo,
+                              stream_buffer_size, false);
+        dma_channel_set_irq0_enabled(dma_channels[i], true);
+    }
+
+    streaming_instance = this;
+    irq_add_shared_handler(MICROPHONE_DMA_IRQ, dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(MICROPHONE_DMA_IRQ, true);
+
+    dma_channel_start(dma_channels[0]);
+    adc_run(true);
+}
+
+void microphone::stop_streaming()
+{
+    if (streaming_instance != this)
+    {
+        return;
+    }
+    adc_run(false);
+
+    // Break the chain before aborting, otherwise an aborted channel can trigger its partner. This has to come before
+    // the interrupts are disabled too: a channel that completes without its handler still triggers its partner, whose
+    // write address was never moved on and points just past the buffer it last filled.
+    for (int i = 0; i < 2; ++i)
+    {
+        dma_channel_config config = dma_channel_get_default_config(dma_channels[i]);
+        channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+        channel_config_set_read_increment(&config, false);
+        channel_config_set_write_increment(&config, true);
+        channel_config_set_dreq(&config, DREQ_ADC);
+        dma_channel_configure(dma_channels[i], &config, &stream_buffers[0], &adc_hw->fifo, 0, false);
+    }
+    irq_set_enabled(MICROPHONE_DMA_IRQ, false); // No completion handler may run while the channels are torn down
+    for (int i = 0; i < 2; ++i)
+    {
+        dma_channel_set_irq0_enabled(dma_channels[i], false);
+    }
+    for (int i = 0; i < 2; ++i)
+    {
+        dma_channel_abort(dma_channels[i]);
+        dma_channel_acknowledge_irq0(dma_channels[i]);
+        dma_channel_unclaim(dma_channels[i]);
+        dma_channels[i] = -1;
+    }
+
+    irq_remove_handler(MICROPHONE_DMA_IRQ, dma_irq_handler);
+    streaming_instance = nullptr;
+
+    adc_fifo_drain();
+    adc_fifo_setup(true, false, 1, false, false); // Back to the polled configuration used by read_blocking
+}
+
+bool microphone::is_buffer_ready() const
+{
+    return buffers_filled != buffers_consumed;
+}
+
+const int16_t *microphone::get_ready_buffer()
+{
+    uint32_t filled = buffers_filled;
+    uint32_t pending = filled - buffers_consumed;
+
+    // One buffer is always being written by the DMA; anything beyond the rest has already been overwritten
+    if (pending > stream_buffer_count - 1)
+    {
+        buffers_dropped = buffers_dropped + pending - (stream_buffer_count - 1);
+        buffers_consumed = filled - (stream_buffer_count - 1);
+    }
+    if (filled == buffers_consumed)
+    {
+        return nullptr;
+    }
+    return &stream_buffers[(buffers_consumed % stream_buffer_count) * stream_buffer_size];
+}
+
+void microphone::release_buffer()
+{
+    if (buffers_filled != buffers_consumed)
+    {
+        buffers_consumed = buffers_consumed + 1;
+    }
+}
+
+uint32_t microphone::get_dropped_buffer_count() const
+{
+    return buffers_dropped;
+}
+
+void microphone::set_event_queue(event_queue *queue)
+{
+    events = queue;
+}
+
+void microphone::dma_irq_handler()
+{
+    microphone *mic = streaming_instance;
+    if (mic == nullptr)
+    {
+        return;
+    }
+    for (int i = 0; i < 2; ++i)
+    {
+        if (mic->dma_channels[i] >= 0 && dma_channel_get_irq0_status(mic->dma_channels[i]))
+        {
+            dma_channel_acknowledge_irq0(mic->dma_channels[i]);
+            mic->handle_dma_complete(i);
+        }
+    }
+}
+
+void microphone::handle_dma_complete(uint channel)
+{
+    const int16_t *completed = &stream_buffers[channel_buffer_index[channel] * stream_buffer_size];
+
+    // The partner channel is already filling the next buffer, so this one takes the buffer after that
+    channel_buffer_index[channel] = (channel_buffer_index[channel] + 2) % stream_buffer_count;
+    dma_channel_set_write_addr(dma_channels[channel], &stream_buffers[channel_buffer_index[channel] * stream_buffer_size],
+                               false);
+
+    buffers_filled = buffers_filled + 1;
+    if (stream_callback != nullptr)
+    {
+        stream_callback(completed, stream_buffer_size);
+    }
+    if (events != nullptr)
+    {
+        events->post(event_type::audio_buffer, (uint8_t)gpio_pin);
+    }
+}
@@ -0,0 +1,101 @@
+#include "sliding_frame.h"
+#include <string.h>
+
+// Constructor
+sample_ring_buffer::sample_ring_buffer()
+    : storage(nullptr), capacity(0), write_index(0), fill(0) {}
+
+void sample_ring_buffer::init(int16_t *storage, size_t capacity)
+{
+    this->storage = storage;
+    this->capacity = capacity;
+    write_index = 0;
+    fill = 0;
+}
+
+void sample_ring_buffer::push(const int16_t *samples, size_t count)
+{
+    // Only the last `capacity` samples can survive, so skip any that would be overwritten straight away
+    if (count > capacity)
+    {
+        samples += count - capacity;
+        count = capacity;
+    }
+
+    // Copy in at most two segments: up to the end of the storage, then from the start
+    size_t first_segment = capacity - write_index;
+    if (first_segment > count)
+    {
+        first_segment = count;
+    }
+    memcpy(&storage[write_index], samples, first_segment * sizeof(int16_t));
+    memcpy(&storage[0], samples + first_segment, (count - first_segment) * sizeof(int16_t));
+
+    write_index = (write_index + count) % capacity;
+    fill = (fill + count > capacity) ? capacity : fill + count;
+}
+
+void sample_ring_buffer::copy_latest(int16_t *destination, size_t count) const
+{
+    size_t start = (write_index + capacity - count) % capacity;
+    size_t first_segment = capacity - start;
+    if (first_segment > count)
+    {
+        first_segment = count;
+    }
+    memcpy(destination, &storage[start], first_segment * sizeof(int16_t));
+    memcpy(destination + first_segment, &storage[0], (count - first_segment) * sizeof(int16_t));
+}
+
+size_t sample_ring_buffer::get_fill() const
+{
+    return fill;
+}
+
+// Constructor
+sliding_frame::sliding_frame()
+    : frame_size(0), hop_size(0), samples_since_frame(0), skipped_frames(0) {}
+
+void sliding_frame::init(int16_t *history, size_t frame_size, size_t hop_size)
+{
+    this->history.init(history, frame_size);
+    this->frame_size = frame_size;
+    this->hop_size = hop_size;
+    samples_since_frame = 0;
+    skipped_frames = 0;
+}
+
+void sliding_frame::push(const int16_t *samples, size_t count)
+{
+    size_t fill_before = history.get_fill();
+    history.push(samples, count);
+    if (fill_before < frame_size && history.get_fill() == frame_size)
+    {
+        // The first frame is due once the history fills, so the samples that filled it are not skipped frames
+        samples_since_frame = hop_size + (fill_before + count - frame_size);
+        return;
+    }
+    samples_since_frame += count;
+}
+
+bool sliding_frame::is_frame_ready() const
+{
+    return history.get_fill() == frame_size && samples_since_frame >= hop_size;
+}
+
+bool sliding_frame::get_frame(int16_t *frame)
+{
+    if (!is_frame_ready())
+    {
+        return false;
+    }
+    skipped_frames += samples_since_frame / hop_size - 1;
+    samples_since_frame %= hop_size; // Stay on the hop grid even if samples arrive in odd sized blocks
+    history.copy_latest(frame, frame_size);
+    return true;
+}
+
+uint32_t sliding_frame::get_skipped_frame_count() const
+{
+    return skipped_frames;
+}
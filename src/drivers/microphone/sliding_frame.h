@@ -0,0 +1,97 @@
+#ifndef SLIDING_FRAME_H
+#define SLIDING_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*! \brief A ring buffer holding the most recent samples of a stream.
+ *
+ * Samples are pushed in blocks as they arrive, overwriting the oldest ones. The latest samples can then be copied
+ * out in chronological order.
+ */
+class sample_ring_buffer
+{
+public:
+    // Constructor
+    sample_ring_buffer();
+
+    /*! \brief Initialise the ring buffer with caller provided storage.
+     *
+     * \param storage Pointer to the buffer used to hold the samples.
+     * \param capacity The number of samples `storage` can hold.
+     */
+    void init(int16_t *storage, size_t capacity);
+
+    /*! \brief Append samples to the ring, overwriting the oldest samples once it is full.
+     *
+     * \param samples Pointer to the samples to append.
+     * \param count The number of samples to append.
+     */
+    void push(const int16_t *samples, size_t count);
+
+    /*! \brief Copy the most recent samples out of the ring, oldest first.
+     *
+     * \param destination Pointer to the buffer to copy the samples to.
+     * \param count The number of samples to copy. Must not exceed the capacity.
+     */
+    void copy_latest(int16_t *destination, size_t count) const;
+
+    /*! \brief Returns the number of samples pushed since `init`, saturating at the capacity. */
+    size_t get_fill() const;
+
+private:
+    int16_t *storage;   /*!< Sample storage */
+    size_t capacity;    /*!< Number of samples in `storage` */
+    size_t write_index; /*!< Position the next sample will be written to (also the oldest sample once full) */
+    size_t fill;        /*!< Number of valid samples in the ring */
+};
+
+/*! \brief Splits a sample stream into overlapping analysis frames.
+ *
+ * A new frame of `frame_size` samples becomes available every `hop_size` samples, so a hop of half the frame size
+ * gives 50% overlap and a quarter gives 75% overlap. If more than one hop arrives between reads, only the most
+ * recent frame is produced so that the analysis always works on the latest audio.
+ */
+class sliding_frame
+{
+public:
+    // Constructor
+    sliding_frame();
+
+    /*! \brief Initialise the frame analyser.
+     *
+     * \param history Storage for `frame_size` samples of history.
+     * \param frame_size The number of samples in each frame.
+     * \param hop_size The number of new samples between the starts of consecutive frames (1 to `frame_size`).
+     */
+    void init(int16_t *history, size_t frame_size, size_t hop_size);
+
+    /*! \brief Append newly captured samples to the stream.
+     *
+     * \param samples Pointer to the captured samples.
+     * \param count The number of samples.
+     */
+    void push(const int16_t *samples, size_t count);
+
+    /*! \brief Returns true if a complete frame with at least one new hop of samples is available. */
+    bool is_frame_ready() const;
+
+    /*! \brief Copy the latest frame out if one is ready.
+     *
+     * \param frame Pointer to a buffer of `frame_size` samples to receive the frame, oldest sample first.
+     * \return true if a frame was copied, false if not enough new samples have arrived yet.
+     */
+    bool get_frame(int16_t *frame);
+
+    /*! \brief Returns the number of frames skipped because they were superseded before being read. */
+    uint32_t get_skipped_frame_count() const;
+
+private:
+    sample_ring_buffer history; /*!< The last `frame_size` samples */
+    size_t frame_size;
+    size_t hop_size;
+    size_t samples_since_frame; /*!< New samples since the last frame was read */
+    uint32_t skipped_frames;
+};
+
+#endif // SLIDING_FRAME_H
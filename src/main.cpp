@@ -2,65 +2,102 @@
 #include <stdint.h>
 #include <cmath>
 #include "pico/stdlib.h"
+#include "tasks/task_scheduler.h"
 #include "tasks/led_task.h"
 #include "tasks/accelerometer_task.h"
 #include "tasks/microphone_task.h"
-#include "tasks/bluetooth_task.cpp" // be sure to change to a header file later on when functions are finalised
+#include "tasks/bluetooth_task.h"
 #include "board.h"
 #include "hardware/gpio.h"
 #include "hardware/pio.h"
 #include "hardware/uart.h"
 #include "WS2812.pio.h"
 #include "drivers/logging/logging.h"
-#include "drivers/leds/led_array.h"
+#include "drivers/logging/deferred_log.h"
+#include "drivers/leds/led_strip.h"
 #include "drivers/leds/colour.h"
 #include "drivers/accelerometer/accelerometer.h"
+#include "drivers/accelerometer/accel_transport.h"
 #include "drivers/microphone/microphone.h"
+#include "drivers/button/button.h"
+#include "utils/event_queue.h"
 
 // Global variables
-volatile bool stop_task = false; // Flag to stop the current task
-volatile int task_index = 0;     // Track the current task
-static int number_of_tasks = 3;
-// Increment task number, ensure task_index is updated in the interrupt
-void increment_task_number(int number_tasks)
-{
-    task_index = (task_index + 1) % number_tasks;
-}
+volatile bool stop_task = false; // Stops a task run on its own with run_task_until_stopped()
 
-// Interrupt handler for button press to switch tasks
-void switch_task_interrupt(uint gpio, uint32_t events)
+// Drain the events posted by interrupt handlers since the last pass. A debounced press of SW1 moves on to the next
+// task, which the scheduler switches to between two steps. The other events only need draining; how long they waited
+// is kept in the queue's stats.
+static void handle_events(event_queue &events, button &sw1, task_scheduler &scheduler)
 {
-    stop_task = true;                       // Set the flag to stop the current task
-    increment_task_number(number_of_tasks); // Update the task index to the next task
+    event next;
+    event change;
+    while (events.poll(next))
+    {
+        if (sw1.filter(next, change) && change.type == event_type::button_pressed)
+        {
+            scheduler.request_next_task();
+        }
+    }
+    if (sw1.update(event_time_us(), change) && change.type == event_type::button_pressed)
+    {
+        scheduler.request_next_task();
+    }
 }
 
 int main()
 {
     stdio_init_all();
-    gpio_init(SW1);
 
-    gpio_set_irq_enabled_with_callback(SW1, GPIO_IRQ_EDGE_FALL, true, &switch_task_interrupt);
-    task_index = 0;
+    // Drivers, created once and shared by every task. They live in main() so that they are built after the driver
+    // internals they refer to, such as the I2C engines.
+    static led_strip<NUM_LEDS> leds;
+#if ACCELEROMETER_TASK_USE_SPI
+    static accel_spi_transport accel_bus(ACCEL_SPI_INSTANCE, ACCEL_SCLK, ACCEL_MOSI, ACCEL_MISO, ACCEL_CS);
+#else
+    static accel_i2c_transport accel_bus(ACCEL_I2C_INSTANCE, ACCEL_SDA, ACCEL_SCL, ACCEL_I2C_ADDRESS);
+#endif
+    static Accelerometer accel(accel_bus);
+    static microphone mic;
+    static button sw1;
+    static event_queue events; // Filled by the GPIO and DMA interrupts, drained by the loop below
+
+    // Tasks, in the order the button steps through them
+    static led_task leds_mode(leds);
+    static accelerometer_task accelerometer_mode(accel, leds);
+    static microphone_task microphone_mode(mic, leds);
+    static bluetooth_task bluetooth_mode(accel);
+    static task_scheduler scheduler;
+
+    leds.init(LED_PIN);
+    accel.init();
+    mic.init(MIC_PIN);
+    accel.set_event_queue(&events);
+    mic.set_event_queue(&events);
+
+    scheduler.add_task(leds_mode);
+    scheduler.add_task(accelerometer_mode);
+    scheduler.add_task(microphone_mode);
+    scheduler.add_task(bluetooth_mode);
+    scheduler.start(0);
+    printf("%d tasks initialised in %lu us\n", scheduler.get_task_count(),
+           (unsigned long)scheduler.get_stats().init_us);
+
+    sw1.init(SW1, events);
+
+    uint32_t switches_reported = 0;
     while (true)
     {
-        stop_task = false; // reset the flag
-        switch (task_index)
+        handle_events(events, sw1, scheduler);
+        scheduler.run_once();
+        const scheduler_stats &stats = scheduler.get_stats();
+        if (stats.switches != switches_reported)
         {
-        case 0:
-            run_led_task();
-            break;
-        case 1:
-            run_accelerometer_task();
-            break;
-        case 2:
-            run_microphone_task();
-            break;
-        case 3:
-            run_bluetooth_task();
-            break;
-        default:
-            break;
+            switches_reported = stats.switches;
+            log_deferred(log_id::task_switched, scheduler.get_active_index(), stats.last_switch_us, stats.max_switch_us);
+            log_deferred(log_id::events_waited, events.get_stats().max_latency_us, events.get_stats().dropped);
         }
+        log_drain(); // Only fills the UART FIFO, so a switch is never held up behind the log
     }
 
     return 0;
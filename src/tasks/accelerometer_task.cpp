@@ -1,76 +1,124 @@
 #include <stdio.h>
 #include <stdint.h> // For using uint8_t
-#include <cmath>    // For exp() function
 #include "pico/stdlib.h"
 #include "tasks/led_task.h" // Include the header for the task function
+#include "tasks/accelerometer_task.h"
 #include "board.h"
 #include "hardware/gpio.h"
 #include "hardware/pio.h"
 
 #include "WS2812.pio.h" // This header file gets produced during compilation from the WS2812.pio file
-#include "drivers/leds/led_array.h"
+#include "drivers/leds/led_strip.h"
+#include "drivers/leds/led_renderer.h"
 #include "drivers/leds/colour.h"
 #include "drivers/accelerometer/accelerometer.h"
+#include "drivers/accelerometer/accel_filter.h"
+#include "drivers/logging/deferred_log.h"
+#include "utils/dsp_tables.h"
 
-void set_led_based_on_accel(float g_value, int led_start_index, led_array &leds, const colour &led_colour)
+// Brightness against distance from an LED's centre, 255 * exp(-A * d^2) with d in g, in Q8. Sampled every
+// ACCELEROMETER_TASK_CURVE_STEP_MG out to where the curve rounds down to 0, and built by the compiler.
+static constexpr auto intensity_curve = make_gaussian<ACCELEROMETER_TASK_CURVE_POINTS>(
+    255.0 * 256, ACCELEROMETER_TASK_CURVE_A, ACCELEROMETER_TASK_CURVE_STEP_MG / 1000.0);
+
+uint8_t accel_led_intensity(int32_t distance_mg)
 {
-    // https://www.desmos.com/calculator/ej79tccscr
+    uint32_t distance = (uint32_t)(distance_mg < 0 ? -distance_mg : distance_mg);
+    uint32_t index = distance / ACCELEROMETER_TASK_CURVE_STEP_MG;
+    if (index >= ACCELEROMETER_TASK_CURVE_POINTS - 1)
+    {
+        return 0; // Past the end of the table the curve is below a quarter of a step
+    }
+    // Interpolate between the two nearest points; the curve only falls, so the difference is never negative
+    uint32_t fraction = distance % ACCELEROMETER_TASK_CURVE_STEP_MG;
+    uint32_t fall = intensity_curve[index] - intensity_curve[index + 1];
+    return (uint8_t)((intensity_curve[index] - fall * fraction / ACCELEROMETER_TASK_CURVE_STEP_MG) >> 8);
+}
 
-    // Set the value of A for the exponential function
-    float A = 3.0f;
-    uint8_t x_0 = static_cast<uint8_t>(255 * exp(-A * ((-1.0f - g_value) * (-1.0f - g_value))));               // x = -1
-    uint8_t x_1 = static_cast<uint8_t>(255 * exp(-A * ((-1.0f / 3.0f - g_value) * (-1.0f / 3.0f - g_value)))); // x = -1/3
-    uint8_t x_2 = static_cast<uint8_t>(255 * exp(-A * ((1.0f / 3.0f - g_value) * (1.0f / 3.0f - g_value))));   // x = 1/3
-    uint8_t x_3 = static_cast<uint8_t>(255 * exp(-A * ((1.0f - g_value) * (1.0f - g_value))));                 // x = 1
+void set_led_based_on_accel(int32_t g_mg, int led_start_index, led_renderer &leds, const colour &led_colour)
+{
+    // https://www.desmos.com/calculator/ej79tccscr
+    // The four LEDs are centred on -1, -1/3, 1/3 and 1 g, and each lights up as the reading gets close to it
+    static const int32_t centres_mg[4] = {-1000, -333, 333, 1000};
 
-    // Create temporary copies of led_colour for each LED
-    colour led0 = led_colour;
-    colour led1 = led_colour;
-    colour led2 = led_colour;
-    colour led3 = led_colour;
+    for (int i = 0; i < 4; i++)
+    {
+        colour led = led_colour; // Temporary copy of led_colour for each LED
+        led.set_value(accel_led_intensity(centres_mg[i] - g_mg));
+        leds.set_colour_individual(led_start_index + i, led);
+    }
+}
 
-    // Set different values for each copy
-    led0.set_value(x_0);
-    led1.set_value(x_1);
-    led2.set_value(x_2);
-    led3.set_value(x_3);
+accelerometer_task::accelerometer_task(Accelerometer &accel, led_array &leds)
+    : accel(accel), leds(leds), renderer(), filter(), samples()
+{
+}
 
-    // Set LED colours with the clamped values
-    leds.set_colour_individual(led_start_index, led0);
-    leds.set_colour_individual(led_start_index + 1, led1);
-    leds.set_colour_individual(led_start_index + 2, led2);
-    leds.set_colour_individual(led_start_index + 3, led3);
+const char *accelerometer_task::get_name() const
+{
+    return "accelerometer";
 }
 
-int run_accelerometer_task()
+void accelerometer_task::init()
 {
-    Accelerometer accel(ACCEL_I2C_INSTANCE, ACCEL_SDA, ACCEL_SCL, ACCEL_I2C_ADDRESS);
-    accel.init();   // Initialize the accelerometer
-    led_array leds; // Create an instance of the leds class
-    leds.init(LED_PIN, 12);
-    int x_led_start_index = 4;
-    int y_led_start_index = 0;
-    int z_led_start_index = 8;
-    colour x_base_colour(255, 0, 0); // Create a red colour object
-    colour y_base_colour(0, 255, 0); // Create a green colour object
-    colour z_base_colour(0, 0, 255); // Create a blue colour object
+    if (!filter.configure(ACCELEROMETER_TASK_FILTER, ACCELEROMETER_TASK_DATA_RATE, ACCELEROMETER_TASK_FILTER_CUTOFF_HZ))
+    {
+        printf("Accelerometer filter cutoff out of range, showing unfiltered readings\n");
+    }
+}
 
-    while (!stop_task)
+void accelerometer_task::resume()
+{
+    renderer.start(leds, ACCELEROMETER_TASK_FPS, ACCELEROMETER_TASK_FADE_FRAMES);
+    filter.reset(); // The last readings are stale, so the filter starts again from the first new one
+    if (!accel.start_fifo(ACCELEROMETER_TASK_DATA_RATE, ACCELEROMETER_TASK_WATERMARK, ACCEL_INT1))
     {
-        float x_g, y_g, z_g;
+        printf("Failed to start the accelerometer FIFO\n");
+    }
+}
 
-        accel.get_xyz_gs(&x_g, &y_g, &z_g); // Read and print the accelerometer data in g's
-        // printf("X: %.2f g, Y: %.2f g, Z: %.2f g\n", x_g, y_g, z_g);
-        //  divide each value by 4 to get 4 bins, (very negative, negative, positive, very positive)
-        //   use this to decide which led to illuminate
-        leds.clear_all();
-        // Call the function for each axis
-        set_led_based_on_accel(x_g, x_led_start_index, leds, x_base_colour);
-        set_led_based_on_accel(y_g, y_led_start_index, leds, y_base_colour);
-        set_led_based_on_accel(z_g, z_led_start_index, leds, z_base_colour);
+void accelerometer_task::step()
+{
+    static const int x_led_start_index = 4;
+    static const int y_led_start_index = 0;
+    static const int z_led_start_index = 8;
+    static constexpr colour x_base_colour(255, 0, 0); // Red
+    static constexpr colour y_base_colour(0, 255, 0); // Green
+    static constexpr colour z_base_colour(0, 0, 255); // Blue
 
-        sleep_us(1); // Adjust the delay as needed
+    if (!accel.is_fifo_read_done())
+    {
+        sleep_us(TASK_IDLE_SLEEP_US); // The batch is coming in over DMA, leaving the core to the renderer
+        return;
+    }
+    int count = accel.finish_fifo_read();
+    if (accel.is_fifo_batch_ready())
+    {
+        accel.start_fifo_read(samples, ACCEL_FIFO_DEPTH); // Collected on a later step
     }
-    leds.clear_all(); // Clear all LEDs
-    return 0;
-}
\ No newline at end of file
+    if (count <= 0)
+    {
+        sleep_us(TASK_IDLE_SLEEP_US); // Nothing to do until INT1 says the sensor has a batch
+        return;
+    }
+
+    // Filter the whole batch in one pass and show its newest sample, which the filter has already smoothed
+    filter.process(samples, count);
+    const accel_sample &newest = samples[count - 1];
+    int16_t x_mg = accel.convert_to_mg(newest.x);
+    int16_t y_mg = accel.convert_to_mg(newest.y);
+    int16_t z_mg = accel.convert_to_mg(newest.z);
+    log_deferred(log_id::accel_reading, x_mg, y_mg, z_mg);
+    renderer.clear_all();
+    set_led_based_on_accel(x_mg, x_led_start_index, renderer, x_base_colour);
+    set_led_based_on_accel(y_mg, y_led_start_index, renderer, y_base_colour);
+    set_led_based_on_accel(z_mg, z_led_start_index, renderer, z_base_colour);
+    renderer.publish(); // Refused while the renderer is behind, in which case a later reading is shown instead
+}
+
+void accelerometer_task::suspend()
+{
+    accel.stop_fifo(); // Waits for any batch still coming in over DMA
+    renderer.stop();
+    leds.clear_all();
+}
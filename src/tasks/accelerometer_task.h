@@ -1,9 +1,62 @@
 
-#include "drivers/leds/led_array.h"
+#ifndef ACCELEROMETER_TASK_H
+#define ACCELEROMETER_TASK_H
+
+#include "board.h"
+#include "tasks/task_scheduler.h"
+#include "drivers/leds/led_renderer.h"
 #include "drivers/leds/colour.h"
 #include "drivers/accelerometer/accelerometer.h"
+#include "drivers/accelerometer/accel_filter.h"
+
+#define ACCELEROMETER_TASK_FPS 60         // Refresh rate of the strip, independent of the accelerometer reads
+#define ACCELEROMETER_TASK_FADE_FRAMES 4  // Frames over which each reading fades in, smoothing out sensor noise
+#define ACCELEROMETER_TASK_CURVE_A 3.0    // Width of each LED's brightness curve, 255 * exp(-A * d^2) for d in g
+#define ACCELEROMETER_TASK_CURVE_STEP_MG 16 // Spacing of the brightness table, a power of 2 so lookups shift
+#define ACCELEROMETER_TASK_CURVE_POINTS 96  // Out to 1.52 g, where the curve is below a quarter of a step
+#define ACCELEROMETER_TASK_USE_SPI 0      // 1 to reach the sensor over SPI at 10 MHz, 0 over I2C at 400 kHz
+#if ACCELEROMETER_TASK_USE_SPI
+#define ACCELEROMETER_TASK_DATA_RATE 1344 // SPI has the bandwidth for the sensor's fastest normal mode rate
+#define ACCELEROMETER_TASK_WATERMARK 21   // A batch is read once the FIFO holds more samples than this, 61 times a second
+#else
+#define ACCELEROMETER_TASK_DATA_RATE 100  // Samples per second collected in the sensor FIFO
+#define ACCELEROMETER_TASK_WATERMARK 3    // A batch is read once the FIFO holds more samples than this, 25 times a second
+#endif
+#define ACCELEROMETER_TASK_FILTER accel_filter_type::low_pass // Applied to every batch before it is shown
+#define ACCELEROMETER_TASK_FILTER_CUTOFF_HZ 8                 // Smooths out hand tremor and knocks, still follows a tilt
+static_assert(ACCELEROMETER_TASK_FILTER_CUTOFF_HZ * ACCEL_FILTER_MIN_CUTOFF_RATIO >= ACCELEROMETER_TASK_DATA_RATE &&
+                  ACCELEROMETER_TASK_FILTER_CUTOFF_HZ * 2 < ACCELEROMETER_TASK_DATA_RATE,
+              "accel_filter refuses this cutoff at the transport's data rate");
+
+/*! \brief Returns the brightness of an LED whose centre is `distance_mg` milli-g from the reading, 0 to 255.
+ *
+ * Follows 255 * exp(-A * d^2) to within one step, from a table instead of soft-float `exp()`.
+ */
+uint8_t accel_led_intensity(int32_t distance_mg);
+
+void set_led_based_on_accel(int32_t g_mg, int led_start_index, led_renderer &leds, const colour &led_colour);
+
+/*! \brief Shows the filtered acceleration on each axis as a spot of light on four LEDs, read in FIFO batches. */
+class accelerometer_task : public task
+{
+public:
+    /*! \param accel The shared, initialised accelerometer.
+     *  \param leds The shared, initialised LED strip.
+     */
+    accelerometer_task(Accelerometer &accel, led_array &leds);
+
+    const char *get_name() const override;
+    void init() override;
+    void resume() override;
+    void step() override;
+    void suspend() override;
 
-extern volatile bool stop_task;
+private:
+    Accelerometer &accel;
+    led_array &leds;
+    led_strip_renderer<NUM_LEDS> renderer; // Refreshes the strip at a steady rate however fast the readings arrive
+    accel_filter filter;
+    accel_sample samples[ACCEL_FIFO_DEPTH];
+};
 
-void set_led_based_on_accel(float g_value, int led_start_index, led_array &leds, const colour &led_colour);
-int run_accelerometer_task();
\ No newline at end of file
+#endif // ACCELEROMETER_TASK_H
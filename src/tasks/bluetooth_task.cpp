@@ -1,35 +1,52 @@
 #include <stdio.h>
 #include <cstdio>
 #include "pico/stdlib.h"
+#include "hardware/gpio.h"
 #include "hardware/uart.h"
-
-#define UART_ID uart1
-#define BAUD_RATE 115200
-#define UART_TX_PIN 8
-#define UART_RX_PIN 9
-extern volatile bool stop_task;
 #include "board.h"
-#include "drivers/accelerometer/accelerometer.h"
+#include "bluetooth_task.h"
+
+bluetooth_task::bluetooth_task(Accelerometer &accel)
+    : accel(accel), next_send_us(0)
+{
+}
 
-void run_bluetooth_task()
+const char *bluetooth_task::get_name() const
 {
+    return "bluetooth";
+}
 
+void bluetooth_task::init()
+{
     uart_init(UART_ID, BAUD_RATE); // board.h
     // Set the TX and RX pins by using the function select on the GPIO
     // Set datasheet for more information on function select
     gpio_set_function(UART_TX_PIN, GPIO_FUNC_UART);
     gpio_set_function(UART_RX_PIN, GPIO_FUNC_UART);
+}
 
-    Accelerometer accel(ACCEL_I2C_INSTANCE, ACCEL_SDA, ACCEL_SCL, ACCEL_I2C_ADDRESS);
-    accel.init(); // Initialize the accelerometer
-    while (!stop_task)
-    {
-        float x_g, y_g, z_g;
-        accel.get_xyz_gs(&x_g, &y_g, &z_g); // Read and print the accelerometer data in g's
-        static char buf[100];
-        snprintf(buf, 100, "%f,%f,%f\n", x_g, y_g, z_g);
-        uart_puts(UART_ID, buf);
+void bluetooth_task::resume()
+{
+    next_send_us = time_us_64(); // Send a reading straight away
+}
 
-        sleep_ms(1000);
+void bluetooth_task::step()
+{
+    uint64_t now_us = time_us_64();
+    if (now_us < next_send_us)
+    {
+        sleep_us(TASK_IDLE_SLEEP_US);
+        return;
     }
-}
\ No newline at end of file
+    next_send_us = now_us + BLUETOOTH_TASK_PERIOD_MS * 1000;
+
+    float x_g, y_g, z_g;
+    accel.get_xyz_gs(&x_g, &y_g, &z_g); // Read and print the accelerometer data in g's
+    static char buf[100];
+    snprintf(buf, 100, "%f,%f,%f\n", x_g, y_g, z_g);
+    uart_puts(UART_ID, buf);
+}
+
+void bluetooth_task::suspend()
+{
+}
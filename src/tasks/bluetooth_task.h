@@ -0,0 +1,31 @@
+#ifndef BLUETOOTH_TASK_H
+#define BLUETOOTH_TASK_H
+
+#include "tasks/task_scheduler.h"
+#include "drivers/accelerometer/accelerometer.h"
+
+#define UART_ID uart1
+#define BAUD_RATE 115200
+#define UART_TX_PIN 8
+#define UART_RX_PIN 9
+#define BLUETOOTH_TASK_PERIOD_MS 1000 // Time between readings sent to the Bluetooth module
+
+/*! \brief Sends the acceleration in g to a Bluetooth UART module as comma separated values, once a period. */
+class bluetooth_task : public task
+{
+public:
+    /*! \param accel The shared, initialised accelerometer. */
+    explicit bluetooth_task(Accelerometer &accel);
+
+    const char *get_name() const override;
+    void init() override;
+    void resume() override;
+    void step() override;
+    void suspend() override;
+
+private:
+    Accelerometer &accel;
+    uint64_t next_send_us; // When step() should send the next reading
+};
+
+#endif // BLUETOOTH_TASK_H
@@ -7,37 +7,56 @@
 #include "WS2812.pio.h" // This header file gets produced during compilation from the WS2812.pio file
 #include "drivers/logging/logging.h"
 
-#include "drivers/leds/led_array.h"
+#include "drivers/leds/led_strip.h"
+#include "drivers/leds/led_renderer.h"
+#include "drivers/leds/led_effects.h"
 #include "drivers/leds/colour.h"
 
 #include "led_task.h"
 
-int run_led_task()
+// A snake of 5 LEDs running along at 20 LEDs a second, cycling through the colour wheel every 2.56 seconds
+static const int snake_length = 5;
+
+led_task::led_task(led_array &leds)
+    : leds(leds), renderer(), snake_colour(EFFECT_Q16_ONE * 100 / 256, 0, 255, 255),
+      snake(colour(255, 255, 255), snake_length, 20 * EFFECT_Q16_ONE, false), effects(), next_frame_us(0)
 {
-    led_array leds; // Create an instance of the leds class
-    leds.init(LED_PIN, 12);
-    int led_range[] = {0, 1, 2, 3, 4, -1}; // Define an array of LED indices, with -1 as the sentinel value
-    colour snake_colour(255, 0, 255);      // Create a purple colour object
-    colour black(0, 0, 0);                 // Create a black colour object
-
-    while (!stop_task)
-    { // Infinite loop to continuously run the following code
-        for (int i = 0; i < 5; i++)
-        {
-            if (led_range[i] == 12)
-            {
-                led_range[i] = 0;
-            }
-            else
-            {
-                led_range[i]++;
-            }
-        }
-        snake_colour.set_hue(snake_colour.get_hue() + 5); // Increment the hue value of the snake colour
-        leds.set_range_color(led_range, snake_colour);
-        leds.set_excluded_range_color(led_range, black);
-
-        sleep_ms(50);
+}
+
+const char *led_task::get_name() const
+{
+    return "led";
+}
+
+void led_task::init()
+{
+    effects.add_layer(snake_colour, effect_blend::over, 255);
+    effects.add_layer(snake, effect_blend::multiply, 255); // The white snake masks the colour
+}
+
+void led_task::resume()
+{
+    renderer.start(leds, LED_TASK_FPS, 0);
+    next_frame_us = time_us_64();
+}
+
+void led_task::step()
+{
+    uint64_t now_us = time_us_64();
+    if (now_us < next_frame_us)
+    {
+        sleep_us(TASK_IDLE_SLEEP_US);
+        return;
     }
-    return 0;
+    effects.render(effect_time_now(), renderer, NUM_LEDS);
+    next_frame_us += 1000000 / LED_TASK_FPS;
+    if (next_frame_us < now_us)
+    {
+        next_frame_us = now_us; // Fell behind, so start afresh instead of drawing the missed frames back to back
+    }
+}
+
+void led_task::suspend()
+{
+    renderer.stop();
 }
@@ -2,7 +2,34 @@
 #ifndef LED_TASK_H
 #define LED_TASK_H
 
-extern volatile bool stop_task;
-int run_led_task();
+#include "board.h"
+#include "tasks/task_scheduler.h"
+#include "drivers/leds/led_array.h"
+#include "drivers/leds/led_renderer.h"
+#include "drivers/leds/led_effects.h"
+
+#define LED_TASK_FPS 60 // Frames drawn and shown per second, independent of the snake's speed
+
+/*! \brief A white snake running along the strip over a turning rainbow. */
+class led_task : public task
+{
+public:
+    /*! \param leds The shared, initialised LED strip. */
+    explicit led_task(led_array &leds);
+
+    const char *get_name() const override;
+    void init() override;
+    void resume() override;
+    void step() override;
+    void suspend() override;
+
+private:
+    led_array &leds;
+    led_strip_renderer<NUM_LEDS> renderer; // Refreshes the strip at a steady rate while step() draws frames
+    rainbow_effect snake_colour;
+    chase_effect snake;
+    led_strip_effects<NUM_LEDS> effects;
+    uint64_t next_frame_us;                // When step() should draw the next frame
+};
 
 #endif // LED_TASK_H
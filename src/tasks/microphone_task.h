@@ -6,19 +6,141 @@
 #include <stdint.h>
 #include "pico/stdlib.h"
 #include "drivers/microphone/microphone.h"
-#include "drivers/leds/led_array.h"
+#include "drivers/microphone/sliding_frame.h"
+#include "drivers/leds/led_strip.h"
 #include "drivers/leds/colour.h"
+#include "utils/spsc_queue.h"
+#include "utils/fixed_log.h"
+#include "utils/dsp_tables.h"
 #include "arm_math.h"
+#include "tasks/task_scheduler.h"
 
-extern volatile bool stop_task;
+#ifndef SAMPLE_SIZE
+#define SAMPLE_SIZE 1024 // FFT size, normally set by the FFT_SIZE CMake option
+#endif
+static_assert(SAMPLE_SIZE >= 32 && SAMPLE_SIZE <= 8192 && (SAMPLE_SIZE & (SAMPLE_SIZE - 1)) == 0,
+              "arm_rfft_q15 supports power of two sizes from 32 to 8192");
+#define ANALYSIS_WINDOW window_type::hann // Window applied to each frame before the FFT
+#define LOWEST_BAND_EDGE_HZ 345           // Upper edge of the lowest LED band; the rest are log spaced up to Nyquist
+#define HOP_SIZE (SAMPLE_SIZE / 4) // New samples between frames: SAMPLE_SIZE / 2 gives 50% overlap, / 4 gives 75%
+#define CAPTURE_BUFFER_COUNT 4      // DMA buffers of HOP_SIZE samples
+#define FRAME_QUEUE_DEPTH 4         // Frames in flight between the capture core and the analysis core
+#define DISPLAY_DYNAMIC_RANGE_DB 40 // Band energies this far below the loudest band are shown as 0
+#define DISPLAY_LAST_HUE 170        // Quiet bands are red (hue 0), the loudest band is blue
+#define DISPLAY_BRIGHTNESS 100      // Brightness of the strip, applied by its output stage
+
+/*! \brief One analysis frame passed from the capture core to the analysis core. */
+struct audio_frame
+{
+    alignas(4) int16_t samples[SAMPLE_SIZE]; // Word aligned for microphone::preprocess_frame
+};
+
+/*! \brief Throughput counters for the microphone pipeline, reset each time the task starts. */
+struct microphone_pipeline_stats
+{
+    volatile uint32_t hops_captured = 0;   /*!< Buffers of HOP_SIZE samples taken from the microphone */
+    volatile uint32_t frames_queued = 0;   /*!< Frames handed from core 0 to core 1 */
+    volatile uint32_t frames_analysed = 0; /*!< Frames that made it through the FFT and onto the LEDs */
+    volatile uint32_t frames_skipped = 0;  /*!< Frames superseded because analysis was behind */
+    volatile size_t max_queue_depth = 0;   /*!< Highest number of frames waiting for core 1 */
+};
+
+/*! \brief Callback told about every frame the task displays.
+ *
+ * \param band_energy_db The energy of each band in dB, unsigned Q8.8.
+ * \param scaled_frequency_bin_sums The 0-255 level shown on each LED.
+ */
+typedef void (*microphone_frame_observer_t)(const uint16_t (&band_energy_db)[12], const uint8_t (&scaled_frequency_bin_sums)[12]);
+
+/*! \brief Shows the spectrum of the microphone input across the strip, one log spaced band per LED.
+ *
+ * Each step takes one hop of audio from the capture DMA. In dual-core mode core 1 is launched on `resume()` to run
+ * the analysis and drive the LEDs, and is stopped again on `suspend()`.
+ */
+class microphone_task : public task
+{
+public:
+    /*! \param mic The shared, initialised microphone.
+     *  \param leds The shared, initialised LED strip.
+     *  \param dual_core If true, core 0 only captures audio and core 1 runs the analysis and drives the LEDs, with
+     *                   frames passed between them through a lock-free queue. If false, everything runs on the calling
+     *                   core.
+     */
+    microphone_task(microphone &mic, led_array &leds, bool dual_core = true);
+
+    const char *get_name() const override;
+    void init() override;
+    void resume() override;
+    void step() override;
+    void suspend() override;
+
+private:
+    microphone &mic;
+    led_array &leds;
+    bool dual_core;
+    arm_rfft_instance_q15 fft_instance;
+    sliding_frame frames;
+    uint8_t saved_brightness; // The strip's brightness before resume(), put back by suspend()
+};
 
 // Function declarations
-void run_microphone_task();
+
+/*! \brief Run the microphone spectrum task on its own, with its own drivers, until `stop_task` is set.
+ *
+ * \param dual_core See `microphone_task`.
+ */
+void run_microphone_task(bool dual_core = true);
+
+/*! \brief Core 1 entry point for the dual-core pipeline: analyse queued frames and update the LEDs. */
+void run_microphone_analysis_core();
+
+/*! \brief Returns the throughput counters of the current (or last) microphone task run. */
+const microphone_pipeline_stats &get_microphone_pipeline_stats();
+
+/*! \brief Install a callback that sees the result of every displayed frame, or `nullptr` to remove it.
+ *
+ * Used by the replay harness to record and check the pipeline output. The callback runs on the core that drives the
+ * LEDs, once they have latched the frame.
+ */
+void set_microphone_frame_observer(microphone_frame_observer_t observer);
+
+/*! \brief Run the spectrum chain on one frame of raw ADC samples.
+ *
+ * Removes the DC offset, windows, transforms and bins the frame, producing a 0-255 level for each LED.
+ *
+ * \param fft_instance An initialised `SAMPLE_SIZE` point real FFT.
+ * \param time_domain_signal `SAMPLE_SIZE` raw samples, ideally 4-byte aligned. Used as scratch space, so its contents
+ *                           are destroyed.
+ * \param band_energy_db Receives the energy of each of the 12 bins in dB, unsigned Q8.8.
+ * \param scaled_frequency_bin_sums Receives the level of each of the 12 bins.
+ */
+void analyse_frame(const arm_rfft_instance_q15 &fft_instance, int16_t time_domain_signal[], uint16_t (&band_energy_db)[12], uint8_t (&scaled_frequency_bin_sums)[12]);
 
 void apply_hanning_window(int16_t time_domain_signal[], const int16_t hanning_window[], size_t sample_size);
-void calculate_spectral_density(int16_t freq_domain_signal[], uint64_t spectral_density[], size_t sample_size);
-void calculate_frequency_bin_sums(const uint64_t spectral_density[], uint16_t (&frequency_bin_sums)[12], uint16_t &max_bin_sum, const size_t freq_bin_boundaries[13]);
-void scale_frequency_bins(const uint16_t (&frequency_bin_sums)[12], uint8_t (&scaled_frequency_bin_sums)[12], uint16_t max_bin_sum);
-void update_leds(led_array &leds, const colour &base_colour, const uint8_t (&scaled_frequency_bin_sums)[12]);
+void calculate_spectral_density(const int16_t freq_domain_signal[], uint32_t spectral_density[], size_t sample_size);
+
+/*! \brief Sum the power in each band and convert it to decibels.
+ *
+ * Sums are accumulated without overflow using only 32-bit arithmetic and converted with `power_to_db_q8`.
+ *
+ * \param spectral_density Power of each FFT bin.
+ * \param band_energy_db Receives the energy of each band in dB, unsigned Q8.8.
+ * \param max_band_energy_db Receives the energy of the loudest band in dB, unsigned Q8.8.
+ * \param freq_bin_boundaries The first FFT bin of each band, followed by one past the last bin of the last band.
+ */
+void calculate_band_energies_db(const uint32_t spectral_density[], uint16_t (&band_energy_db)[12], uint16_t &max_band_energy_db, const size_t freq_bin_boundaries[13]);
+
+/*! \brief Map band energies onto 0-255 display levels.
+ *
+ * The loudest band maps to 255 and bands `DISPLAY_DYNAMIC_RANGE_DB` or more below it map to 0, so the display
+ * follows loudness on a log scale instead of being dominated by the single loudest band.
+ */
+void scale_band_energies(const uint16_t (&band_energy_db)[12], uint8_t (&scaled_frequency_bin_sums)[12], uint16_t max_band_energy_db);
+
+/*! \brief Show one display level per LED, coloured through a palette.
+ *
+ * \param palette Colour for each level, e.g. from `make_hue_palette`.
+ */
+void update_leds(led_array &leds, const colour_palette &palette, const uint8_t (&scaled_frequency_bin_sums)[12]);
 
 #endif
@@ -0,0 +1,142 @@
+#include "task_scheduler.h"
+#include "pico/stdlib.h"
+
+task_scheduler::task_scheduler()
+    : tasks(), task_count(0), active(-1), requested(-1), request_count(0), handled_count(0), request_time_us(0),
+      switch_request_us(0), stats()
+{
+}
+
+bool task_scheduler::add_task(task &new_task)
+{
+    if (task_count >= SCHEDULER_MAX_TASKS)
+    {
+        return false;
+    }
+    tasks[task_count++] = &new_task;
+    return true;
+}
+
+void task_scheduler::start(int first_task)
+{
+    uint64_t init_start_us = time_us_64();
+    for (int i = 0; i < task_count; i++)
+    {
+        tasks[i]->init();
+    }
+    stats.init_us = (uint32_t)(time_us_64() - init_start_us);
+
+    if (first_task >= 0 && first_task < task_count)
+    {
+        active = first_task;
+        tasks[active]->resume();
+    }
+}
+
+void task_scheduler::run_once()
+{
+    bool switched = is_switch_pending() && switch_task();
+    if (active >= 0)
+    {
+        tasks[active]->step();
+    }
+    if (switched)
+    {
+        record_switch(); // Only now has the new task done anything
+    }
+}
+
+void task_scheduler::run()
+{
+    while (true)
+    {
+        run_once();
+    }
+}
+
+void task_scheduler::request_next_task()
+{
+    if (task_count == 0)
+    {
+        return;
+    }
+    // Repeated presses before the switch happens move further along, as they would have done one at a time
+    int from = is_switch_pending() ? requested : active;
+    request_task((from + 1) % task_count);
+}
+
+void task_scheduler::request_task(int index)
+{
+    if (index < 0 || index >= task_count)
+    {
+        return;
+    }
+    if (!is_switch_pending())
+    {
+        request_time_us = time_us_64(); // The latency counts from the first request still waiting
+    }
+    requested = index;
+    request_count = request_count + 1; // Published last, so the scheduler never sees a count without its index
+}
+
+int task_scheduler::get_active_index() const
+{
+    return active;
+}
+
+int task_scheduler::get_task_count() const
+{
+    return task_count;
+}
+
+const scheduler_stats &task_scheduler::get_stats() const
+{
+    return stats;
+}
+
+bool task_scheduler::is_switch_pending() const
+{
+    return request_count != handled_count;
+}
+
+bool task_scheduler::switch_task()
+{
+    // Anything requested after the count is read is handled on the next pass
+    uint32_t seen = request_count;
+    int next = requested;
+    switch_request_us = request_time_us; // A request during the first step must not move the start of this one
+    handled_count = seen;
+    if (next == active)
+    {
+        return false; // Pressed all the way round, or asked for the running task
+    }
+    if (active >= 0)
+    {
+        tasks[active]->suspend();
+    }
+    active = next;
+    tasks[active]->resume();
+    return true;
+}
+
+void task_scheduler::record_switch()
+{
+    uint32_t latency_us = (uint32_t)(time_us_64() - switch_request_us);
+    stats.last_switch_us = latency_us;
+    if (latency_us > stats.max_switch_us)
+    {
+        stats.max_switch_us = latency_us;
+    }
+    stats.switches = stats.switches + 1;
+}
+
+void run_task_until_stopped(task &standalone_task)
+{
+    standalone_task.init();
+    standalone_task.resume();
+    while (!stop_task)
+    {
+        standalone_task.step();
+    }
+    standalone_task.suspend();
+}
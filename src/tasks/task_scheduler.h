@@ -0,0 +1,123 @@
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <stdint.h>
+
+#define SCHEDULER_MAX_TASKS 4       // Tasks one scheduler can switch between
+#define TASK_IDLE_SLEEP_US 100      // How long a task with nothing to do sleeps in step(), and so its share of the latency
+
+extern volatile bool stop_task;
+
+/*! \brief A task that the scheduler switches between, such as one mode of the board.
+ *
+ * Tasks are long-lived objects that borrow drivers created once at start-up. Instead of owning a loop, a task does a
+ * small, bounded piece of work in each `step()` and returns, so the scheduler can switch away from it between any two
+ * steps. Expensive one-off set-up belongs in `init()`; `resume()` and `suspend()` should only start and stop what the
+ * task runs in the background (timers, DMA, core 1), so that switching takes microseconds.
+ */
+class task
+{
+public:
+    virtual ~task() = default;
+
+    /*! \brief Returns a short name for the task, for logging. */
+    virtual const char *get_name() const = 0;
+
+    /*! \brief One-off set-up, such as designing filters or building tables. Called once, before the first `resume()`. */
+    virtual void init() = 0;
+
+    /*! \brief Makes this the running task: starts its background work and takes over the shared drivers. */
+    virtual void resume() = 0;
+
+    /*! \brief Does one bounded piece of work, returning within about `TASK_IDLE_SLEEP_US` if there is none. */
+    virtual void step() = 0;
+
+    /*! \brief Stops the task's background work and leaves the shared drivers free for the next task. */
+    virtual void suspend() = 0;
+};
+
+/*! \brief Timing of the switches made by a `task_scheduler`. */
+struct scheduler_stats
+{
+    volatile uint32_t switches = 0;        /*!< Switches completed */
+    volatile uint32_t last_switch_us = 0;  /*!< Request to the end of the new task's first step, latest switch */
+    volatile uint32_t max_switch_us = 0;   /*!< Longest switch so far */
+    volatile uint32_t init_us = 0;         /*!< Time spent in every task's `init()` by `start()` */
+};
+
+/*! \brief Cooperative scheduler that runs one task at a time and switches between them on request.
+ *
+ * Switches can be requested from an interrupt handler, such as a button press. The scheduler finishes the current
+ * step, suspends the running task and resumes the requested one, and measures the time from the request to the end of
+ * the new task's first step.
+ * Every task is initialised once by `start()`, so no switch pays for set-up.
+ */
+class task_scheduler
+{
+public:
+    task_scheduler();
+
+    /*! \brief Adds a task, which must outlive the scheduler. Tasks are numbered in the order they are added.
+     *
+     * \return false if `SCHEDULER_MAX_TASKS` tasks have already been added.
+     */
+    bool add_task(task &new_task);
+
+    /*! \brief Initialises every task and resumes the task with the given index. */
+    void start(int first_task = 0);
+
+    /*! \brief Handles a pending switch, then steps the running task once. */
+    void run_once();
+
+    /*! \brief Runs the tasks for ever. */
+    [[noreturn]] void run();
+
+    /*! \brief Asks for a switch to the task after the running (or already requested) one. Safe to call from an
+     * interrupt handler.
+     */
+    void request_next_task();
+
+    /*! \brief Asks for a switch to the task with the given index. Safe to call from an interrupt handler. Out of range
+     * indices are ignored.
+     */
+    void request_task(int index);
+
+    /*! \brief Returns the index of the running task, or -1 before `start()`. */
+    int get_active_index() const;
+
+    /*! \brief Returns the number of tasks added. */
+    int get_task_count() const;
+
+    /*! \brief Returns the switch timing counters. */
+    const scheduler_stats &get_stats() const;
+
+private:
+    /*! \brief Suspends the running task and resumes the requested one.
+     *
+     * \return false if the requested task was already running.
+     */
+    bool switch_task();
+
+    /*! \brief Updates the stats once the task switched to has finished its first step. */
+    void record_switch();
+
+    /*! \brief Returns true if a request has arrived since the last switch. */
+    bool is_switch_pending() const;
+
+    // Requests are written only by the requester and `handled_count` only by the scheduler, so a request that arrives
+    // during a switch is never lost, without disabling interrupts
+    task *tasks[SCHEDULER_MAX_TASKS];
+    int task_count;
+    int active;                         // Index of the running task, or -1 before start()
+    volatile int requested;             // Index of the task most recently asked for
+    volatile uint32_t request_count;    // Requests made so far
+    volatile uint32_t handled_count;    // Requests acted on so far
+    volatile uint64_t request_time_us;  // When the oldest pending request was made
+    uint64_t switch_request_us;         // When the request behind the switch in progress was made
+    scheduler_stats stats;
+};
+
+/*! \brief Runs a single task on its own until `stop_task` is set, for harnesses that drive one task directly. */
+void run_task_until_stopped(task &standalone_task);
+
+#endif // TASK_SCHEDULER_H
@@ -0,0 +1,200 @@
+#ifndef DSP_TABLES_H
+#define DSP_TABLES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+
+/*! \brief Compile-time generators for lookup tables, mostly the spectrum analyser's.
+ *
+ * Everything here is `constexpr`, so tables declared as `constexpr` (or `static constexpr`) are computed by the
+ * compiler and stored in flash: changing the FFT size, window or band layout costs nothing at run time and no tables
+ * need to be pasted in by hand.
+ */
+
+/*! \brief Supported analysis windows. */
+enum class window_type
+{
+    hann,            /*!< Good general purpose window, -31 dB sidelobes */
+    hamming,         /*!< Narrower main lobe than Hann, -43 dB first sidelobe but slow roll-off */
+    blackman_harris, /*!< 4-term Blackman-Harris, -92 dB sidelobes for a wide dynamic range */
+    flat_top,        /*!< Accurate amplitudes at the cost of frequency resolution */
+};
+
+namespace dsp_tables_detail
+{
+    constexpr double pi = 3.14159265358979323846;
+    constexpr double ln2 = 0.69314718055994530942;
+
+    // Cosine by range reduction to [0, pi/2] and a Taylor series, accurate to double precision
+    constexpr double cos(double x)
+    {
+        x = x < 0 ? -x : x;
+        x -= 2 * pi * (double)(long long)(x / (2 * pi));
+        if (x > pi)
+        {
+            x = 2 * pi - x;
+        }
+        double sign = 1;
+        if (x > pi / 2)
+        {
+            x = pi - x;
+            sign = -1;
+        }
+        double term = 1;
+        double sum = 1;
+        for (int n = 1; n < 12; ++n)
+        {
+            term *= -x * x / ((2 * n - 1) * (2 * n));
+            sum += term;
+        }
+        return sign * sum;
+    }
+
+    // Natural logarithm by reduction to [1, 2) and the atanh series, for positive x
+    constexpr double log(double x)
+    {
+        int exponent = 0;
+        while (x >= 2)
+        {
+            x /= 2;
+            ++exponent;
+        }
+        while (x < 1)
+        {
+            x *= 2;
+            --exponent;
+        }
+        double y = (x - 1) / (x + 1);
+        double term = y;
+        double sum = 0;
+        for (int n = 1; n < 60; n += 2)
+        {
+            sum += term / n;
+            term *= y * y;
+        }
+        return 2 * sum + exponent * ln2;
+    }
+
+    // Exponential by halving into the fast converging range of the Taylor series and squaring back up
+    constexpr double exp(double x)
+    {
+        int halvings = 0;
+        while (x > 0.5 || x < -0.5)
+        {
+            x /= 2;
+            ++halvings;
+        }
+        double term = 1;
+        double sum = 1;
+        for (int n = 1; n < 20; ++n)
+        {
+            term *= x / n;
+            sum += term;
+        }
+        for (int i = 0; i < halvings; ++i)
+        {
+            sum *= sum;
+        }
+        return sum;
+    }
+
+    // Window value at position n of a symmetric window of `length` points
+    constexpr double window_value(window_type type, size_t n, size_t length)
+    {
+        double phase = 2 * pi * (double)n / (double)(length - 1);
+        switch (type)
+        {
+        case window_type::hann:
+            return 0.5 - 0.5 * cos(phase);
+        case window_type::hamming:
+            return 0.54 - 0.46 * cos(phase);
+        case window_type::blackman_harris:
+            return 0.35875 - 0.48829 * cos(phase) + 0.14128 * cos(2 * phase) - 0.01168 * cos(3 * phase);
+        default: // window_type::flat_top
+            return 0.21557895 - 0.41663158 * cos(phase) + 0.277263158 * cos(2 * phase) - 0.083578947 * cos(3 * phase) +
+                   0.006947368 * cos(4 * phase);
+        }
+    }
+}
+
+/*! \brief Generate a symmetric window of N points in Q15.
+ *
+ * Values are rounded to the nearest Q15 step and saturated, so the Hann window reproduces the table the spectrum
+ * task originally used.
+ *
+ * \tparam N The number of points, normally the FFT size.
+ * \tparam TYPE The window shape.
+ */
+template <size_t N, window_type TYPE>
+constexpr std::array<int16_t, N> make_window()
+{
+    std::array<int16_t, N> window{};
+    for (size_t n = 0; n < N; ++n)
+    {
+        double scaled = dsp_tables_detail::window_value(TYPE, n, N) * 32768.0;
+        long long rounded = (long long)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+        window[n] = (int16_t)(rounded > 32767 ? 32767 : (rounded < -32768 ? -32768 : rounded));
+    }
+    return window;
+}
+
+/*! \brief Generate logarithmically spaced band boundaries for a real FFT.
+ *
+ * The first band runs from DC up to `lowest_band_edge_hz`. The remaining bands are spaced evenly on a log scale up
+ * to the Nyquist bin, and every band gets at least one FFT bin. Band `b` covers FFT bins
+ * `[boundaries[b], boundaries[b + 1])`.
+ *
+ * \tparam FFT_SIZE The number of points in the FFT.
+ * \tparam BANDS The number of bands.
+ * \param sample_rate_hz The sample rate of the analysed signal.
+ * \param lowest_band_edge_hz The upper edge of the first band.
+ */
+template <size_t FFT_SIZE, size_t BANDS>
+constexpr std::array<size_t, BANDS + 1> make_band_boundaries(double sample_rate_hz, double lowest_band_edge_hz)
+{
+    static_assert(BANDS >= 2 && BANDS <= FFT_SIZE / 2, "each band needs at least one FFT bin");
+
+    std::array<size_t, BANDS + 1> boundaries{};
+    const size_t nyquist_bin = FFT_SIZE / 2;
+    size_t first_edge = (size_t)(lowest_band_edge_hz * FFT_SIZE / sample_rate_hz);
+    first_edge = first_edge < 1 ? 1 : first_edge;
+    const double log_ratio = dsp_tables_detail::log((double)nyquist_bin / (double)first_edge);
+
+    boundaries[0] = 0;
+    for (size_t band = 1; band < BANDS; ++band)
+    {
+        double edge = first_edge * dsp_tables_detail::exp(log_ratio * (double)(band - 1) / (double)(BANDS - 1));
+        boundaries[band] = (size_t)(edge + 1e-9); // Nudge so that exact powers are not floored one bin low
+        if (boundaries[band] <= boundaries[band - 1])
+        {
+            boundaries[band] = boundaries[band - 1] + 1; // Small FFTs: keep every band at least one bin wide
+        }
+    }
+    boundaries[BANDS] = nyquist_bin;
+    return boundaries;
+}
+
+/*! \brief Generate samples of a Gaussian curve, `peak * exp(-a * x^2)`, rounded to integers.
+ *
+ * Entry `n` is the value at `x = n * step`, so the table covers `x` from 0 to `(N - 1) * step`. It is meant to be
+ * interpolated linearly, which keeps the error well under one unit for steps small against the curve's width.
+ *
+ * \tparam N The number of points.
+ * \param peak The value at `x = 0`, at most 65535.
+ * \param a The width parameter: larger is narrower.
+ * \param step The spacing of the points.
+ */
+template <size_t N>
+constexpr std::array<uint16_t, N> make_gaussian(double peak, double a, double step)
+{
+    std::array<uint16_t, N> table{};
+    for (size_t n = 0; n < N; ++n)
+    {
+        double x = (double)n * step;
+        table[n] = (uint16_t)(peak * dsp_tables_detail::exp(-a * x * x) + 0.5);
+    }
+    return table;
+}
+
+#endif // DSP_TABLES_H
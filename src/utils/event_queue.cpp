@@ -0,0 +1,37 @@
+#include "event_queue.h"
+#include "pico/stdlib.h"
+
+uint32_t event_time_us()
+{
+    return (uint32_t)time_us_64();
+}
+
+bool event_queue::post(event_type type, uint8_t source, bool active)
+{
+    if (!events.push({type, source, active, event_time_us()}))
+    {
+        stats.dropped = stats.dropped + 1;
+        return false;
+    }
+    stats.posted = stats.posted + 1;
+    return true;
+}
+
+bool event_queue::poll(event &next)
+{
+    if (!events.pop(next))
+    {
+        return false;
+    }
+    uint32_t latency_us = event_time_us() - next.time_us;
+    if (latency_us > stats.max_latency_us)
+    {
+        stats.max_latency_us = latency_us;
+    }
+    return true;
+}
+
+const event_queue_stats &event_queue::get_stats() const
+{
+    return stats;
+}
@@ -0,0 +1,70 @@
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <stdint.h>
+#include "utils/spsc_queue.h"
+
+#define EVENT_QUEUE_DEPTH 32 // Events waiting for the main loop, a power of two
+
+/*! \brief What an interrupt handler is reporting. */
+enum class event_type : uint8_t
+{
+    button_edge,     /*!< A button pin changed level, before debouncing */
+    button_pressed,  /*!< A debounced press, from `button::filter()` */
+    button_released, /*!< A debounced release, from `button::filter()` */
+    accel_watermark, /*!< The accelerometer FIFO passed its watermark (INT1) */
+    audio_buffer,    /*!< The microphone capture DMA filled a buffer */
+};
+
+/*! \brief One timestamped event, small enough to copy through the queue. */
+struct event
+{
+    event_type type;
+    uint8_t source;   /*!< The instance that posted it, such as the GPIO pin */
+    bool active;      /*!< For buttons, true if pressed */
+    uint32_t time_us; /*!< `event_time_us()` when posted */
+};
+
+/*! \brief Counters for tuning the queue depth and checking how quickly events are handled. */
+struct event_queue_stats
+{
+    volatile uint32_t posted = 0;         /*!< Events queued by interrupt handlers */
+    volatile uint32_t dropped = 0;        /*!< Events lost because the queue was full */
+    volatile uint32_t max_latency_us = 0; /*!< Longest time from posting to `poll()` */
+};
+
+/*! \brief Returns the time in microseconds for event timestamps. Wraps every 71 minutes, so compare timestamps by
+ * subtracting them.
+ */
+uint32_t event_time_us();
+
+/*! \brief Events passed from interrupt handlers to the main loop without locks or disabling interrupts.
+ *
+ * Built on `spsc_queue`, so there must be a single producer. Interrupt handlers at the same priority never preempt
+ * each other and so count as one: the GPIO, DMA and accelerometer handlers all use the SDK default priority and may
+ * all post to one queue, as long as they run on the same core.
+ */
+class event_queue
+{
+public:
+    /*! \brief Producer: queues an event stamped with the current time.
+     *
+     * \return false if the queue was full and the event was dropped.
+     */
+    bool post(event_type type, uint8_t source, bool active = false);
+
+    /*! \brief Consumer: takes the oldest event.
+     *
+     * \return false if there was none.
+     */
+    bool poll(event &next);
+
+    /*! \brief Returns the counters. */
+    const event_queue_stats &get_stats() const;
+
+private:
+    spsc_queue<event, EVENT_QUEUE_DEPTH> events;
+    event_queue_stats stats;
+};
+
+#endif // EVENT_QUEUE_H
@@ -0,0 +1,28 @@
+#ifndef FIXED_LOG_H
+#define FIXED_LOG_H
+
+#include <stdint.h>
+
+/*! \brief Base 2 logarithm of a 64-bit value, in unsigned Q8.8 fixed point.
+ *
+ * The value is passed as two 32-bit halves so that callers can accumulate wide sums without 64-bit arithmetic. The
+ * integer part comes from the position of the leading one and the fraction from a 256-entry lookup table indexed by
+ * the 8 bits that follow it, giving a resolution of 1/256.
+ *
+ * \param high The most significant 32 bits of the value.
+ * \param low The least significant 32 bits of the value.
+ * \return log2(value) in Q8.8, or 0 when the value is 0.
+ */
+uint16_t log2_q8(uint32_t high, uint32_t low);
+
+/*! \brief Converts a 64-bit power (energy) value to decibels in unsigned Q8.8 fixed point.
+ *
+ * Returns 10 * log10(value), i.e. 0 dB for a power of 1 and about 192.7 dB for the largest 64-bit value.
+ *
+ * \param high The most significant 32 bits of the power value.
+ * \param low The least significant 32 bits of the power value.
+ * \return The power in dB, Q8.8.
+ */
+uint16_t power_to_db_q8(uint32_t high, uint32_t low);
+
+#endif // FIXED_LOG_H
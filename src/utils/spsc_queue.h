@@ -0,0 +1,115 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+/*! \brief A bounded, lock-free, single-producer single-consumer queue.
+ *
+ * One side (a core, a task or an interrupt handler) pushes and exactly one other side pops. Neither side ever blocks
+ * or disables interrupts: the producer only writes `head` and the consumer only writes `tail`, and the acquire/release
+ * ordering on those counters publishes the slot contents. This makes it safe between the two RP2040 cores and
+ * between an interrupt handler and the code it interrupts.
+ *
+ * Large items can be filled and read in place with `begin_push()`/`end_push()` and `front()`/`pop()` to avoid
+ * copying them through the queue.
+ *
+ * \tparam T The item type.
+ * \tparam CAPACITY The maximum number of queued items. Must be a power of two.
+ */
+template <typename T, size_t CAPACITY>
+class spsc_queue
+{
+    static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "spsc_queue capacity must be a power of two");
+
+public:
+    // Constructor
+    spsc_queue() : head(0), tail(0) {}
+
+    /*! \brief Producer: copy an item into the queue.
+     *
+     * \return true if the item was queued, false if the queue was full.
+     */
+    bool push(const T &item)
+    {
+        T *slot = begin_push();
+        if (slot == nullptr)
+        {
+            return false;
+        }
+        *slot = item;
+        end_push();
+        return true;
+    }
+
+    /*! \brief Consumer: copy the oldest item out of the queue.
+     *
+     * \return true if an item was removed, false if the queue was empty.
+     */
+    bool pop(T &item)
+    {
+        T *slot = front();
+        if (slot == nullptr)
+        {
+            return false;
+        }
+        item = *slot;
+        pop();
+        return true;
+    }
+
+    /*! \brief Producer: returns the next free slot to fill in place, or `nullptr` if the queue is full. */
+    T *begin_push()
+    {
+        uint32_t current_head = head.load(std::memory_order_relaxed);
+        if (current_head - tail.load(std::memory_order_acquire) == CAPACITY)
+        {
+            return nullptr;
+        }
+        return &items[current_head % CAPACITY];
+    }
+
+    /*! \brief Producer: publishes the slot returned by `begin_push()` to the consumer. */
+    void end_push()
+    {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /*! \brief Consumer: returns the oldest item to read in place, or `nullptr` if the queue is empty. */
+    T *front()
+    {
+        uint32_t current_tail = tail.load(std::memory_order_relaxed);
+        if (head.load(std::memory_order_acquire) == current_tail)
+        {
+            return nullptr;
+        }
+        return &items[current_tail % CAPACITY];
+    }
+
+    /*! \brief Consumer: hands the slot returned by `front()` back to the producer. */
+    void pop()
+    {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /*! \brief Returns the number of queued items. Only a snapshot when the other side is active. */
+    size_t size() const
+    {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    /*! \brief Empties the queue. Only safe while neither side is using it. */
+    void clear()
+    {
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    T items[CAPACITY];
+    std::atomic<uint32_t> head; /*!< Number of items ever pushed, only written by the producer */
+    std::atomic<uint32_t> tail; /*!< Number of items ever popped, only written by the consumer */
+};
+
+#endif // SPSC_QUEUE_H
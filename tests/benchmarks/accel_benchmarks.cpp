@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmath>
+#include "benchmark.h"
+#include "board.h"
+#include "drivers/accelerometer/accelerometer.h"
+#include "drivers/accelerometer/accel_filter.h"
+#include "tasks/accelerometer_task.h"
+
+#define ACCEL_REFERENCE_TOLERANCE 1 // Largest brightness difference from the floating point mapping that is accepted
+#define FILTER_TOLERANCE_DB 0.5     // Largest difference from the ideal response accepted, where it is above -40 dB
+#define FILTER_SAMPLE_RATE 100.0    // The accelerometer task's rate over I2C
+#define FILTER_TEST_AMPLITUDE 8000  // Raw amplitude of the test sines, half a g
+
+// The floating point mapping that the table replaces: brightness of the four LEDs of one axis for a reading in g
+static void reference_intensities(float g_value, uint8_t intensities[4])
+{
+    float A = 3.0f;
+    intensities[0] = static_cast<uint8_t>(255 * exp(-A * ((-1.0f - g_value) * (-1.0f - g_value))));
+    intensities[1] = static_cast<uint8_t>(255 * exp(-A * ((-1.0f / 3.0f - g_value) * (-1.0f / 3.0f - g_value))));
+    intensities[2] = static_cast<uint8_t>(255 * exp(-A * ((1.0f / 3.0f - g_value) * (1.0f / 3.0f - g_value))));
+    intensities[3] = static_cast<uint8_t>(255 * exp(-A * ((1.0f - g_value) * (1.0f - g_value))));
+}
+
+// The integer mapping used by the accelerometer task
+static void fixed_intensities(int32_t g_mg, uint8_t intensities[4])
+{
+    static const int32_t centres_mg[4] = {-1000, -333, 333, 1000};
+    for (int i = 0; i < 4; i++) {
+        intensities[i] = accel_led_intensity(centres_mg[i] - g_mg);
+    }
+}
+
+// Compare every raw reading against the reference. Returns the largest difference in any LED.
+static int check_against_reference(Accelerometer &accel)
+{
+    int worst = 0;
+    for (int raw = -32768; raw < 32768; raw++) {
+        uint8_t expected[4];
+        uint8_t actual[4];
+        reference_intensities(accel.convert_to_g((int16_t)raw), expected);
+        fixed_intensities(accel.convert_to_mg((int16_t)raw), actual);
+        for (int i = 0; i < 4; i++) {
+            int error = abs(actual[i] - expected[i]);
+            worst = error > worst ? error : worst;
+        }
+    }
+    return worst;
+}
+
+// Ideal gain of each filter as designed: the analogue prototypes through the bilinear transform, or the DC blocker's
+// own transfer function
+static double reference_gain(accel_filter_type type, double f, double cutoff)
+{
+    const double pi = 3.14159265358979323846;
+    double warped = tan(pi * f / FILTER_SAMPLE_RATE) / tan(pi * cutoff / FILTER_SAMPLE_RATE);
+    switch (type) {
+    case accel_filter_type::low_pass:
+        return 1 / sqrt(1 + pow(warped, 8));
+    case accel_filter_type::high_pass:
+        return 1 / sqrt(1 + pow(1 / warped, 8));
+    case accel_filter_type::gravity_removal: {
+        double r = exp(-2 * pi * cutoff / FILTER_SAMPLE_RATE);
+        double w = 2 * pi * f / FILTER_SAMPLE_RATE;
+        return (1 + r) / 2 * 2 * sin(w / 2) / sqrt(1 - 2 * r * cos(w) + r * r);
+    }
+    default:
+        return 1;
+    }
+}
+
+// Gain of a filter at `f`, from a sine on the X axis run through it in FIFO sized batches and correlated once settled
+static double measured_gain(accel_filter &filter, double f)
+{
+    const double pi = 3.14159265358979323846;
+    const int settle = 2000;
+    int period_samples = (int)lround(FILTER_SAMPLE_RATE / f);
+    int measure = period_samples * (4000 / period_samples + 1); // Whole periods, so the correlation is unbiased
+    double in_phase = 0;
+    double quadrature = 0;
+    int n = 0;
+    filter.reset();
+    while (n < settle + measure) {
+        accel_sample batch[ACCEL_FIFO_DEPTH];
+        for (int i = 0; i < ACCEL_FIFO_DEPTH; i++) {
+            batch[i] = {(int16_t)lround(FILTER_TEST_AMPLITUDE * sin(2 * pi * f * (n + i) / FILTER_SAMPLE_RATE)), 0, 0, 0};
+        }
+        filter.process(batch, ACCEL_FIFO_DEPTH);
+        for (int i = 0; i < ACCEL_FIFO_DEPTH; i++, n++) {
+            if (n >= settle && n < settle + measure) {
+                double phase = 2 * pi * f * n / FILTER_SAMPLE_RATE;
+                in_phase += batch[i].x * sin(phase);
+                quadrature += batch[i].x * cos(phase);
+            }
+        }
+    }
+    return 2 * sqrt(in_phase * in_phase + quadrature * quadrature) / measure / FILTER_TEST_AMPLITUDE;
+}
+
+// Compare a filter's response with the ideal at frequencies from 0.1 Hz to just under Nyquist. Returns the largest
+// difference in dB, where the ideal response is above -40 dB, or infinity if the filter refuses the design.
+static double check_filter_response(accel_filter_type type, double cutoff)
+{
+    static const double frequencies[] = {0.1, 0.2, 0.5, 1, 2, 3, 5, 8, 10, 15, 20, 25, 30, 40, 45};
+    accel_filter filter;
+    if (!filter.configure(type, FILTER_SAMPLE_RATE, cutoff)) {
+        return INFINITY;
+    }
+    double worst = 0;
+    for (double f : frequencies) {
+        double expected = reference_gain(type, f, cutoff);
+        if (expected < 0.01) {
+            continue; // Deep in the stop band, where only the rounding noise is left to measure
+        }
+        double error = fabs(20 * log10(measured_gain(filter, f) / expected));
+        worst = error > worst ? error : worst;
+    }
+    return worst;
+}
+
+int run_accel_benchmarks(bool accuracy_only)
+{
+    // Only the conversions are used, so the sensor is never initialised
+    static accel_i2c_transport transport(ACCEL_I2C_INSTANCE, ACCEL_SDA, ACCEL_SCL, ACCEL_I2C_ADDRESS);
+    static Accelerometer accel(transport);
+
+    int reference_error = check_against_reference(accel);
+    printf("\n== Accelerometer LED mapping accuracy ==\n");
+    printf("Raw -> LED brightness, all 2^16 readings: max error %d vs floating point (%s)\n", reference_error,
+           reference_error <= ACCEL_REFERENCE_TOLERANCE ? "ok" : "FAILED");
+    int failures = reference_error <= ACCEL_REFERENCE_TOLERANCE ? 0 : 1;
+
+    struct {
+        const char *name;
+        accel_filter_type type;
+        double cutoff;
+    } filters[] = {
+        {"low_pass, 8 Hz", accel_filter_type::low_pass, 8},
+        {"high_pass, 8 Hz", accel_filter_type::high_pass, 8},
+        {"gravity_removal, 0.5 Hz", accel_filter_type::gravity_removal, 0.5},
+    };
+
+    printf("\n== Accelerometer filter response at %.0f Hz ==\n", FILTER_SAMPLE_RATE);
+    for (const auto &f : filters) {
+        double error = check_filter_response(f.type, f.cutoff);
+        printf("%-24s max error %.3f dB vs ideal (%s)\n", f.name, error, error <= FILTER_TOLERANCE_DB ? "ok" : "FAILED");
+        failures += error <= FILTER_TOLERANCE_DB ? 0 : 1;
+    }
+
+    if (accuracy_only) {
+        return failures;
+    }
+
+    int16_t raw = 0;
+    uint8_t intensities[4];
+    benchmark_report_header("Accelerometer to LEDs", "leds", "reading");
+    double float_ns = benchmark_measure([&] {
+        reference_intensities(accel.convert_to_g(raw += 37), intensities);
+        benchmark_keep(intensities);
+    });
+    benchmark_report("convert_to_g + exp() (float)", 4, float_ns);
+    double fixed_ns = benchmark_measure([&] {
+        fixed_intensities(accel.convert_to_mg(raw += 37), intensities);
+        benchmark_keep(intensities);
+    });
+    benchmark_report("convert_to_mg + table (integer)", 4, fixed_ns);
+    printf("%-36s %8d %14.1fx\n", "  speedup", 4, fixed_ns > 0 ? float_ns / fixed_ns : 0.0);
+
+    // Each call filters one FIFO batch on all three axes
+    benchmark_report_header("Accelerometer filter", "batch", "sample");
+    accel_sample input[ACCEL_FIFO_DEPTH];
+    accel_sample batch[ACCEL_FIFO_DEPTH];
+    for (int i = 0; i < ACCEL_FIFO_DEPTH; i++) {
+        input[i] = {(int16_t)(i * 517), (int16_t)(-i * 301), (int16_t)(16000 + i * 7), 0};
+    }
+    for (const auto &f : filters) {
+        accel_filter filter;
+        filter.configure(f.type, FILTER_SAMPLE_RATE, f.cutoff);
+        double ns = benchmark_measure([&] { memcpy(batch, input, sizeof(batch)); },
+                                      [&] {
+                                          filter.process(batch, ACCEL_FIFO_DEPTH);
+                                          benchmark_keep(batch);
+                                      });
+        benchmark_report(f.name, ACCEL_FIFO_DEPTH, ns / ACCEL_FIFO_DEPTH);
+    }
+    return failures;
+}
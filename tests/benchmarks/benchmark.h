@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdio.h>
+#include <stddef.h>
+#include <chrono>
+
+// Minimum time spent measuring each stage, long enough to average out scheduler noise
+#define BENCHMARK_MIN_DURATION std::chrono::milliseconds(50)
+
+/*! \brief Stops the optimiser from discarding a result that is otherwise unused. */
+template <typename T>
+inline void benchmark_keep(const T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/*! \brief Times `stage`, calling `prepare` (untimed) before every call so that stages which work in place always see
+ * fresh input.
+ *
+ * The cost of `prepare` is measured separately and subtracted.
+ *
+ * \return The average time of one call of `stage` in nanoseconds.
+ */
+template <typename Prepare, typename Stage>
+double benchmark_measure(Prepare prepare, Stage stage)
+{
+    using clock = std::chrono::steady_clock;
+
+    // Double the batch size until one batch takes long enough to time accurately
+    size_t iterations = 1;
+    for (;;) {
+        auto start = clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            prepare();
+            stage();
+        }
+        if (clock::now() - start >= BENCHMARK_MIN_DURATION) {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    auto start = clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        prepare();
+        stage();
+    }
+    auto with_stage = clock::now() - start;
+
+    start = clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        prepare();
+    }
+    auto prepare_only = clock::now() - start;
+
+    double ns = std::chrono::duration<double, std::nano>(with_stage - prepare_only).count() / iterations;
+    return ns > 0 ? ns : 0;
+}
+
+/*! \brief Times a stage that needs no fresh input. */
+template <typename Stage>
+double benchmark_measure(Stage stage)
+{
+    return benchmark_measure([] {}, stage);
+}
+
+/*! \brief Prints the column headings for `benchmark_report`. `unit` names one call of a stage, e.g. "frame". */
+inline void benchmark_report_header(const char *title, const char *size_heading, const char *unit)
+{
+    char ns_heading[32];
+    char rate_heading[32];
+    snprintf(ns_heading, sizeof(ns_heading), "ns/%s", unit);
+    snprintf(rate_heading, sizeof(rate_heading), "%ss/sec", unit);
+    printf("\n== %s ==\n", title);
+    printf("%-36s %8s %14s %16s\n", "stage", size_heading, ns_heading, rate_heading);
+}
+
+/*! \brief Prints one result line. */
+inline void benchmark_report(const char *stage, size_t size, double ns_per_call)
+{
+    printf("%-36s %8zu %14.1f %16.0f\n", stage, size, ns_per_call, ns_per_call > 0 ? 1e9 / ns_per_call : 0.0);
+}
+
+// Benchmark groups, one per area of the code. Each runs its accuracy checks first and returns how many failed; with
+// `accuracy_only` set it returns straight after them, without timing anything.
+int run_dsp_benchmarks(bool accuracy_only);
+int run_colour_benchmarks(bool accuracy_only);
+int run_effects_benchmarks(bool accuracy_only);
+int run_accel_benchmarks(bool accuracy_only);
+int run_logging_benchmarks(bool accuracy_only);
@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <cmath>
+#include "benchmark.h"
+#include "drivers/leds/colour.h"
+
+#define COLOUR_REFERENCE_TOLERANCE 2 // Largest difference from the floating point converter that is accepted
+
+// Textbook floating point HSV to RGB, with hue 0-255 covering one turn, as the reference for the integer converter
+static void reference_hsv_to_rgb(uint8_t h, uint8_t s, uint8_t v, int rgb[3])
+{
+    double hue = h * 6.0 / 256.0;
+    double saturation = s / 255.0;
+    double value = v / 255.0;
+    int sector = (int)hue;
+    double fraction = hue - sector;
+    double p = value * (1 - saturation);
+    double q = value * (1 - saturation * fraction);
+    double t = value * (1 - saturation * (1 - fraction));
+    double channels[6][3] = {{value, t, p}, {q, value, p}, {p, value, t},
+                             {p, q, value}, {t, p, value}, {value, p, q}};
+    for (int i = 0; i < 3; i++) {
+        rgb[i] = (int)lround(channels[sector][i] * 255);
+    }
+}
+
+// Compare every hue, saturation and value against the reference. Returns the largest difference in any channel.
+static int check_against_reference()
+{
+    int worst = 0;
+    for (int h = 0; h < 256; h++) {
+        for (int s = 0; s < 256; s++) {
+            for (int v = 0; v < 256; v++) {
+                colour fast = colour::from_hsv(h, s, v);
+                int expected[3];
+                reference_hsv_to_rgb(h, s, v, expected);
+                int actual[3] = {fast.get_red(), fast.get_green(), fast.get_blue()};
+                for (int i = 0; i < 3; i++) {
+                    int error = abs(actual[i] - expected[i]);
+                    worst = error > worst ? error : worst;
+                }
+            }
+        }
+    }
+    return worst;
+}
+
+// Convert every RGB colour to HSV and back. Returns the largest change in any channel of a saturated colour.
+static int check_round_trip()
+{
+    int worst = 0;
+    for (int r = 0; r < 256; r += 5) {
+        for (int g = 0; g < 256; g += 5) {
+            for (int b = 0; b < 256; b += 5) {
+                colour original(r, g, b);
+                colour converted = colour::from_hsv(original.get_hue(), original.get_saturation(), original.get_value());
+                int errors[3] = {abs(converted.get_red() - r), abs(converted.get_green() - g), abs(converted.get_blue() - b)};
+                for (int error : errors) {
+                    worst = (original.get_saturation() == 255 && error > worst) ? error : worst;
+                }
+            }
+        }
+    }
+    return worst;
+}
+
+int run_colour_benchmarks(bool accuracy_only)
+{
+    int reference_error = check_against_reference();
+    printf("\n== Colour conversion accuracy ==\n");
+    printf("HSV -> RGB, all 2^24 inputs: max error %d vs floating point reference (%s)\n", reference_error,
+           reference_error <= COLOUR_REFERENCE_TOLERANCE ? "ok" : "FAILED");
+    printf("RGB -> HSV -> RGB, saturated colours: max error %d\n", check_round_trip());
+    int failures = reference_error <= COLOUR_REFERENCE_TOLERANCE ? 0 : 1;
+    if (accuracy_only) {
+        return failures;
+    }
+
+    static constexpr colour_palette palette = make_hue_palette(0, 170, 255, 100);
+    uint8_t level = 0;
+    uint8_t hue = 0;
+
+    benchmark_report_header("Colour engine", "leds", "led");
+    benchmark_report("colour::from_hsv", 1, benchmark_measure([&] {
+                         benchmark_keep(colour::from_hsv(hue++, 255, 100));
+                     }));
+    benchmark_report("set_hue + set_value", 1, benchmark_measure([&] {
+                         colour c(0, 255, 255);
+                         c.set_hue(hue++);
+                         c.set_value(100);
+                         benchmark_keep(c);
+                     }));
+    benchmark_report("colour(r, g, b) (RGB -> HSV)", 1, benchmark_measure([&] {
+                         benchmark_keep(colour(hue++, 80, 200));
+                     }));
+    benchmark_report("palette lookup", 1, benchmark_measure([&] {
+                         benchmark_keep(palette[level++]);
+                     }));
+    return failures;
+}
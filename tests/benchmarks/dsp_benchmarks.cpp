@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <string.h>
+#include <cmath>
+#include "benchmark.h"
+#include "tasks/microphone_task.h"
+
+// Fill `raw` with a repeatable test signal in raw ADC units: two tones and some pseudo-random noise around mid-rail
+static void make_test_signal(int16_t raw[], size_t size)
+{
+    uint32_t noise = 12345;
+    for (size_t i = 0; i < size; ++i)
+    {
+        noise = noise * 1103515245 + 12345;
+        double t = i / MICROPHONE_SAMPLE_RATE_HZ;
+        double value = 2048 + 600 * sin(2 * M_PI * 440 * t) + 200 * sin(2 * M_PI * 3000 * t) + ((noise >> 16) % 64) - 32;
+        raw[i] = (int16_t)value;
+    }
+}
+
+#define PREPROCESS_CHECK_RUNS 2000 // Random buffers compared against the two-pass version
+
+// Samples that hit the corners of the fused arithmetic: the ends of the ADC range, the values either side of where
+// (x - DC_OFFSET) << 5 wraps at 16 bits, and values outside the ADC range altogether
+static const int16_t edge_samples[] = {0, 1, 1023, 1024, 1025, 2047, 2048, 2049, 3071, 3072, 3073, 4094, 4095,
+                                       -1, -32768, 32767, 4096, 8191, -2048};
+static const int16_t edge_coefficients[] = {-32768, -32767, -1, 0, 1, 16384, 32766, 32767};
+
+// Run the fused and single-pass preprocessing against the original two-pass code (offset and scale, then window) over
+// random and edge-case input, with buffers at every alignment and lengths that leave every size of tail. Returns the
+// number of samples that differ.
+static size_t check_preprocess_bit_exact()
+{
+    alignas(4) static int16_t expected[72];
+    alignas(4) static int16_t fused[72];
+    alignas(4) static int16_t single_pass[72];
+    alignas(4) static int16_t window[72];
+    uint32_t random = 1;
+    auto next_random = [&] {
+        random = random * 1103515245 + 12345;
+        return random >> 8;
+    };
+
+    size_t differences = 0;
+    for (int run = 0; run < PREPROCESS_CHECK_RUNS; run++)
+    {
+        size_t data_offset = run % 4;
+        size_t window_offset = (run / 4) % 4;
+        size_t length = next_random() % (72 - 4 + 1);
+        for (size_t i = 0; i < length; i++)
+        {
+            uint32_t pick = next_random();
+            int16_t sample;
+            if (pick % 4 == 0)
+            {
+                sample = edge_samples[(pick >> 2) % (sizeof(edge_samples) / sizeof(edge_samples[0]))];
+            }
+            else if (pick % 4 == 1)
+            {
+                sample = (int16_t)(pick >> 2); // Anything at all
+            }
+            else
+            {
+                sample = (int16_t)((pick >> 2) % 4096); // Anything the ADC can give
+            }
+            expected[data_offset + i] = sample;
+            fused[data_offset + i] = sample;
+            single_pass[data_offset + i] = sample;
+
+            uint32_t coefficient_pick = next_random();
+            size_t edge_index = (coefficient_pick >> 2) % (sizeof(edge_coefficients) / sizeof(edge_coefficients[0]));
+            window[window_offset + i] =
+                (coefficient_pick % 4 == 0) ? edge_coefficients[edge_index] : (int16_t)(coefficient_pick >> 2);
+        }
+
+        microphone::remove_offset_and_scale(&expected[data_offset], length);
+        apply_hanning_window(&expected[data_offset], &window[window_offset], length);
+        microphone::preprocess_frame(&fused[data_offset], &window[window_offset], length);
+        microphone::preprocess_frame_reference(&single_pass[data_offset], &window[window_offset], length);
+        for (size_t i = 0; i < length; i++)
+        {
+            differences += (fused[data_offset + i] != expected[data_offset + i]) ? 1 : 0;
+            differences += (single_pass[data_offset + i] != expected[data_offset + i]) ? 1 : 0;
+        }
+    }
+    return differences;
+}
+
+// Run every stage of the spectrum chain for one FFT size
+template <size_t N>
+static void benchmark_fft_size()
+{
+    alignas(4) static constexpr std::array<int16_t, N> window = make_window<N, ANALYSIS_WINDOW>();
+    static constexpr std::array<size_t, 13> boundaries =
+        make_band_boundaries<N, 12>(MICROPHONE_SAMPLE_RATE_HZ, LOWEST_BAND_EDGE_HZ);
+    alignas(4) static int16_t raw[N];
+    alignas(4) static int16_t time_domain[N];
+    static int16_t freq_domain[N + 2];
+    static uint32_t density[N / 2 + 1];
+    uint16_t band_energy_db[12] = {0};
+    uint16_t max_band_energy_db = 0;
+    uint8_t scaled[12] = {0};
+
+    arm_rfft_instance_q15 fft_instance;
+    arm_rfft_init_q15(&fft_instance, N, 0, 1);
+    make_test_signal(raw, N);
+
+    // Fresh raw samples for the stages that work in place
+    auto load_raw = [&] { memcpy(time_domain, raw, sizeof(raw)); };
+
+    // Run the chain once so that every intermediate buffer holds realistic data
+    load_raw();
+    microphone::preprocess_frame(time_domain, window.data(), N);
+    alignas(4) static int16_t windowed[N];
+    memcpy(windowed, time_domain, sizeof(windowed));
+    arm_rfft_q15(&fft_instance, time_domain, freq_domain);
+    calculate_spectral_density(freq_domain, density, N);
+    calculate_band_energies_db(density, band_energy_db, max_band_energy_db, boundaries.data());
+    auto load_windowed = [&] { memcpy(time_domain, windowed, sizeof(windowed)); };
+
+    benchmark_report("two-pass offset/scale + window", N, benchmark_measure(load_raw, [&] {
+                         microphone::remove_offset_and_scale(time_domain, N);
+                         apply_hanning_window(time_domain, window.data(), N);
+                     }));
+    benchmark_report("preprocess_frame_reference", N, benchmark_measure(load_raw, [&] {
+                         microphone::preprocess_frame_reference(time_domain, window.data(), N);
+                     }));
+    benchmark_report("preprocess_frame (fused)", N, benchmark_measure(load_raw, [&] {
+                         microphone::preprocess_frame(time_domain, window.data(), N);
+                     }));
+    benchmark_report("arm_rfft_q15", N, benchmark_measure(load_windowed, [&] {
+                         arm_rfft_q15(&fft_instance, time_domain, freq_domain);
+                     }));
+    benchmark_report("calculate_spectral_density", N, benchmark_measure([&] {
+                         calculate_spectral_density(freq_domain, density, N);
+                     }));
+    benchmark_report("calculate_band_energies_db", N, benchmark_measure([&] {
+                         calculate_band_energies_db(density, band_energy_db, max_band_energy_db, boundaries.data());
+                     }));
+    benchmark_report("scale_band_energies", N, benchmark_measure([&] {
+                         scale_band_energies(band_energy_db, scaled, max_band_energy_db);
+                         benchmark_keep(scaled);
+                     }));
+    benchmark_report("full frame", N, benchmark_measure(load_raw, [&] {
+                         microphone::preprocess_frame(time_domain, window.data(), N);
+                         arm_rfft_q15(&fft_instance, time_domain, freq_domain);
+                         calculate_spectral_density(freq_domain, density, N);
+                         calculate_band_energies_db(density, band_energy_db, max_band_energy_db, boundaries.data());
+                         scale_band_energies(band_energy_db, scaled, max_band_energy_db);
+                         benchmark_keep(scaled);
+                     }));
+}
+
+int run_dsp_benchmarks(bool accuracy_only)
+{
+    size_t differences = check_preprocess_bit_exact();
+    printf("\n== Microphone preprocessing accuracy ==\n");
+    printf("preprocess_frame vs two-pass, %d random and edge-case buffers: %zu samples differ (%s)\n",
+           PREPROCESS_CHECK_RUNS, differences, differences == 0 ? "ok" : "FAILED");
+    int failures = differences == 0 ? 0 : 1;
+    if (accuracy_only)
+    {
+        return failures;
+    }
+
+    benchmark_report_header("Microphone spectrum chain", "points", "frame");
+    benchmark_fft_size<256>();
+    benchmark_fft_size<512>();
+    benchmark_fft_size<1024>();
+    benchmark_fft_size<2048>();
+    return failures;
+}
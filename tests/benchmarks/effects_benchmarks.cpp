@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include "benchmark.h"
+#include "drivers/leds/led_effects.h"
+
+// Rough ratio of RP2040 time to host time for this integer code: a 125 MHz Cortex-M0+ against a desktop core of about
+// 4 GHz. Replace it with a measurement from the board when there is one.
+#define EFFECTS_RP2040_SLOWDOWN 150
+#define EFFECTS_RP2040_BUDGET_NS (1e9 / 60 / 4) // A quarter of a 60 FPS frame, leaving the rest of core 0 to the tasks
+
+// Time one frame of an effect on its own, then as a layer on top of another
+template <int STRIP_LEDS>
+static void benchmark_effect(const char *name, const led_effect &effect, effect_blend blend)
+{
+    static led_strip_effects<STRIP_LEDS> stack;
+    static rainbow_effect base(EFFECT_Q16_ONE / 4, 256, 255, 255);
+    effect_time_t now = 0;
+
+    stack.clear_layers();
+    stack.add_layer(effect, effect_blend::over, 255);
+    benchmark_report(name, STRIP_LEDS, benchmark_measure([&] {
+                         benchmark_keep(stack.render(now += 1092, STRIP_LEDS)); // About 60 FPS of effect time
+                     }));
+
+    stack.clear_layers();
+    stack.add_layer(base, effect_blend::over, 255);
+    stack.add_layer(effect, blend, 128);
+    double both = benchmark_measure([&] {
+        benchmark_keep(stack.render(now += 1092, STRIP_LEDS));
+    });
+    stack.clear_layers();
+    stack.add_layer(base, effect_blend::over, 255);
+    double base_only = benchmark_measure([&] {
+        benchmark_keep(stack.render(now += 1092, STRIP_LEDS));
+    });
+    benchmark_report("  as a layer at half opacity", STRIP_LEDS, both > base_only ? both - base_only : 0);
+}
+
+template <int STRIP_LEDS>
+static void benchmark_effects()
+{
+    chase_effect chase(colour(255, 0, 255), 5, 20 * EFFECT_Q16_ONE, true);
+    breathe_effect breathe(colour(255, 255, 255), 2 * EFFECT_Q16_ONE, 0);
+    rainbow_effect rainbow(EFFECT_Q16_ONE / 4, 256, 255, 255);
+    sparkle_effect sparkle(colour(255, 255, 255), 40, EFFECT_Q16_ONE / 2, 1);
+    gradient_effect gradient(colour(255, 0, 0), colour(0, 0, 255), EFFECT_Q16_ONE / 4);
+
+    benchmark_effect<STRIP_LEDS>("chase", chase, effect_blend::lighten);
+    benchmark_effect<STRIP_LEDS>("breathe", breathe, effect_blend::multiply);
+    benchmark_effect<STRIP_LEDS>("rainbow", rainbow, effect_blend::over);
+    benchmark_effect<STRIP_LEDS>("sparkle", sparkle, effect_blend::add);
+    benchmark_effect<STRIP_LEDS>("gradient", gradient, effect_blend::over);
+
+    // A full stack, to see how many layers fit in a frame
+    static led_strip_effects<STRIP_LEDS> stack;
+    const led_effect *effects[] = {&rainbow, &gradient, &chase, &sparkle, &breathe, &rainbow, &gradient, &sparkle};
+    const effect_blend blends[] = {effect_blend::over, effect_blend::over, effect_blend::lighten, effect_blend::add,
+                                   effect_blend::multiply, effect_blend::over, effect_blend::over, effect_blend::add};
+    stack.clear_layers();
+    for (int i = 0; i < LED_EFFECTS_MAX_LAYERS; i++) {
+        stack.add_layer(*effects[i], blends[i], 160);
+    }
+    effect_time_t now = 0;
+    double ns = benchmark_measure([&] {
+        benchmark_keep(stack.render(now += 1092, STRIP_LEDS));
+    });
+    char name[64];
+    snprintf(name, sizeof(name), "%d mixed layers", LED_EFFECTS_MAX_LAYERS);
+    benchmark_report(name, STRIP_LEDS, ns);
+
+    // The stack's cost scaled to the board, as the number of layers that fit in the LED task's share of a frame
+    double layer_ns = ns / LED_EFFECTS_MAX_LAYERS * EFFECTS_RP2040_SLOWDOWN;
+    printf("%-36s %8d %14.1f\n", "  per layer, RP2040 estimate", STRIP_LEDS, layer_ns);
+    printf("%-36s %8d %14.0f\n", "  RP2040 layers in 1/4 of a frame", STRIP_LEDS,
+           EFFECTS_RP2040_BUDGET_NS / layer_ns);
+}
+
+int run_effects_benchmarks(bool accuracy_only)
+{
+    if (accuracy_only) {
+        return 0; // Nothing to check
+    }
+    benchmark_report_header("LED effects", "leds", "frame");
+    benchmark_effects<12>();
+    benchmark_effects<144>();
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "benchmark.h"
+#include "hardware/uart.h"
+#include "drivers/logging/logging.h"
+#include "drivers/logging/deferred_log.h"
+
+#define LOGGING_UART_BAUD 115200     // The stdio UART on the board
+#define LOGGING_UART_BITS_PER_BYTE 10 // Start, eight data and stop bits
+#define LOGGING_UART_FIFO_BYTES 32   // Bytes the UART takes before the caller has to wait
+
+// Time `stage` in batches of `batch` calls, with `reset` run untimed before each batch. For stages that fill a buffer,
+// so that every timed call sees the same state. Returns the average time of one call in nanoseconds.
+template <typename Reset, typename Stage>
+static double measure_in_batches(size_t batch, Reset reset, Stage stage)
+{
+    using clock = std::chrono::steady_clock;
+    clock::duration total{};
+    size_t calls = 0;
+    while (total < BENCHMARK_MIN_DURATION) {
+        reset();
+        auto start = clock::now();
+        for (size_t i = 0; i < batch; i++) {
+            stage();
+        }
+        total += clock::now() - start;
+        calls += batch;
+    }
+    return std::chrono::duration<double, std::nano>(total).count() / calls;
+}
+
+static void drain_all()
+{
+    while (log_drain() > 0) {
+    }
+}
+
+// Time on the board's UART for `bytes`, in microseconds
+static double uart_time_us(size_t bytes)
+{
+    return bytes * LOGGING_UART_BITS_PER_BYTE * 1e6 / LOGGING_UART_BAUD;
+}
+
+int run_logging_benchmarks(bool accuracy_only)
+{
+    if (accuracy_only) {
+        return 0; // Nothing to check
+    }
+    mock_uart_set_capture(uart0, nullptr); // Frames are only sent to be timed
+
+    // log() prints, so send stdout to /dev/null while it is timed. This only counts the formatting; on the board the
+    // line then has to go out over the UART, which is shown below.
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    int null_output = open("/dev/null", O_WRONLY);
+    dup2(null_output, STDOUT_FILENO);
+    double log_ns = benchmark_measure([] {
+        log(LogLevel::INFORMATION, "Switched to task 1 in 812 us (longest 950 us)");
+    });
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(null_output);
+    close(saved_stdout);
+
+    // On the host, masking interrupts takes the mock's interrupt lock, which is most of the cost of log_deferred()
+    uint32_t value = 0;
+    drain_all();
+    double deferred_ns = measure_in_batches(DEFERRED_LOG_DEPTH, drain_all, [&] {
+        log_deferred(log_id::task_switched, 1, value++, 950);
+    });
+    double dropped_ns = measure_in_batches(DEFERRED_LOG_DEPTH, [] {}, [&] {
+        log_deferred(log_id::task_switched, 1, value++, 950); // The buffer stays full, so every call is dropped
+    });
+    drain_all();
+    // One log_drain() sends everything waiting while the UART has room, so time a full buffer and share it out
+    double drain_ns = measure_in_batches(1, [&] {
+        for (size_t i = 0; i < DEFERRED_LOG_DEPTH; i++) {
+            log_deferred(log_id::task_switched, 1, value++, 950);
+        }
+    }, drain_all) / DEFERRED_LOG_DEPTH;
+
+    benchmark_report_header("Logging", "args", "call");
+    benchmark_report("log() to /dev/null (formatting only)", 0, log_ns);
+    benchmark_report("log_deferred", 3, deferred_ns);
+    benchmark_report("log_deferred, buffer full (dropped)", 3, dropped_ns);
+    benchmark_report("log_drain, per frame", 3, drain_ns);
+
+    // What the caller waits for on the board: log() blocks once its line overflows the UART FIFO, while
+    // log_deferred() never touches the UART and log_drain() stops when the FIFO is full
+    char line[128];
+    size_t line_bytes = snprintf(line, sizeof(line), "[%u.%03u %s]: %s\n", 12u, 345u, "Information",
+                                 "Switched to task 1 in 812 us (longest 950 us)");
+    size_t blocked_bytes = line_bytes > LOGGING_UART_FIFO_BYTES ? line_bytes - LOGGING_UART_FIFO_BYTES : 0;
+    printf("\n== Logging on the board's UART (%d baud) ==\n", LOGGING_UART_BAUD);
+    printf("log():        %3zu bytes per message, %6.0f us on the wire, caller blocked for about %.0f us\n",
+           line_bytes, uart_time_us(line_bytes), uart_time_us(blocked_bytes));
+    printf("log_deferred: %3zu bytes per message, %6.0f us on the wire, caller never blocked\n",
+           (size_t)LOG_FRAME_SIZE, uart_time_us(LOG_FRAME_SIZE));
+    return 0;
+}
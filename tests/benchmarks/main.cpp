@@ -0,0 +1,31 @@
+// Usage: benchmarks [--accuracy-only]
+//
+// Runs every accuracy check and benchmark, or with --accuracy-only just the checks, as ctest does. Exits with 1 if any
+// check failed.
+
+#include <stdio.h>
+#include <string.h>
+#include "benchmark.h"
+
+// Needed by the task code that is linked in alongside the functions under test
+volatile bool stop_task = false;
+
+int main(int argc, char *argv[])
+{
+    bool accuracy_only = argc == 2 && strcmp(argv[1], "--accuracy-only") == 0;
+    if (argc > 1 && !accuracy_only) {
+        fprintf(stderr, "Usage: %s [--accuracy-only]\n", argv[0]);
+        return 2;
+    }
+
+    printf("Native benchmarks (host CPU, so compare runs against each other rather than against the RP2040)\n");
+    int failures = 0;
+    failures += run_dsp_benchmarks(accuracy_only);
+    failures += run_colour_benchmarks(accuracy_only);
+    failures += run_effects_benchmarks(accuracy_only);
+    failures += run_accel_benchmarks(accuracy_only);
+    failures += run_logging_benchmarks(accuracy_only);
+
+    printf("\n%d accuracy checks failed\n", failures);
+    return failures == 0 ? 0 : 1;
+}
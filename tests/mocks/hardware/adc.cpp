@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+
+#define ADC_CLOCK_HZ 48000000.0
+#define SAMPLES_PER_PACING_STEP 64 // sleeping per sample is far too coarse, so pace in small blocks
+
+static adc_hw_t mock_adc_hw;
+adc_hw_t *adc_hw = &mock_adc_hw;
+
+static uint16_t mock_adc_tone();
+static uint32_t mock_adc_fifo_read();
+
+static std::atomic<mock_adc_source_t> adc_source(mock_adc_tone);
+static std::atomic<bool> adc_realtime(true);
+static std::atomic<bool> adc_running(false);
+static double adc_sample_period_ns = 96.0 * 1000000000.0 / ADC_CLOCK_HZ;
+static uint32_t adc_sample_count = 0;
+static std::chrono::steady_clock::time_point adc_next_deadline;
+
+// Default source: a 1 kHz sine wave with a quarter of full scale amplitude
+static uint16_t mock_adc_tone()
+{
+    static uint32_t n = 0;
+    double t = (n++ * adc_sample_period_ns) / 1000000000.0;
+    return (uint16_t)(2048 + 512 * sin(2 * M_PI * 1000.0 * t));
+}
+
+void adc_init()
+{
+    mock_dma_register_source(&adc_hw->fifo, mock_adc_fifo_read);
+}
+
+// Reads of the FIFO register by the DMA mock
+static uint32_t mock_adc_fifo_read()
+{
+    return mock_adc_next_sample();
+}
+
+void adc_gpio_init(unsigned int gpio)
+{
+    printf("Debug: ADC initialised on GPIO pin %u\n", gpio);
+}
+
+void adc_select_input(unsigned int input)
+{
+}
+
+void adc_set_clkdiv(float clkdiv)
+{
+    adc_sample_period_ns = (1.0 + clkdiv) * 1000000000.0 / ADC_CLOCK_HZ;
+}
+
+void adc_fifo_setup(bool en, bool dreq_en, uint16_t dreq_thresh, bool err_in_fifo, bool byte_shift)
+{
+}
+
+void adc_run(bool run)
+{
+    if (run && !adc_running.load()) {
+        adc_next_deadline = std::chrono::steady_clock::now();
+        adc_sample_count = 0;
+    }
+    adc_running.store(run);
+}
+
+uint16_t adc_fifo_get_blocking()
+{
+    return mock_adc_next_sample();
+}
+
+void adc_fifo_drain()
+{
+}
+
+void mock_adc_set_source(mock_adc_source_t source)
+{
+    adc_source.store(source);
+}
+
+void mock_adc_set_realtime(bool realtime)
+{
+    adc_realtime.store(realtime);
+}
+
+uint16_t mock_adc_next_sample()
+{
+    if (adc_realtime.load() && (++adc_sample_count % SAMPLES_PER_PACING_STEP) == 0) {
+        adc_next_deadline += std::chrono::nanoseconds((int64_t)(adc_sample_period_ns * SAMPLES_PER_PACING_STEP));
+        std::this_thread::sleep_until(adc_next_deadline);
+    }
+    return adc_source.load()() & 0x0FFF;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+// Register block, so that drivers can point a DMA channel at the FIFO
+typedef struct {
+    volatile uint32_t fifo;
+} adc_hw_t;
+extern adc_hw_t *adc_hw;
+
+#define DREQ_ADC 36
+
+// Functions defined to replicate the real API
+void adc_init();
+void adc_gpio_init(unsigned int gpio);
+void adc_select_input(unsigned int input);
+void adc_set_clkdiv(float clkdiv);
+void adc_fifo_setup(bool en, bool dreq_en, uint16_t dreq_thresh, bool err_in_fifo, bool byte_shift);
+void adc_run(bool run);
+uint16_t adc_fifo_get_blocking();
+void adc_fifo_drain();
+
+// Test harness: a source of 12-bit samples. The default source is a 1 kHz tone around the 2048 mid-rail.
+typedef uint16_t (*mock_adc_source_t)(void);
+void mock_adc_set_source(mock_adc_source_t source);
+
+// Test harness: when true (the default) samples are delivered at the rate set by `adc_set_clkdiv`, otherwise as fast
+// as they are requested.
+void mock_adc_set_realtime(bool realtime);
+
+// Test harness: produce the next conversion. Called by the DMA mock when it reads from `adc_hw->fifo`.
+uint16_t mock_adc_next_sample();
@@ -0,0 +1,315 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+// State of one mocked channel. Each channel that has ever been triggered gets a worker thread that performs the
+// transfers, so channels run concurrently just like on the real bus.
+struct mock_dma_channel {
+    dma_channel_config config;
+    volatile void *write_addr;
+    const volatile void *read_addr;
+    uint32_t trans_count;
+    bool claimed;
+    bool irq0_enabled;
+    bool irq1_enabled;
+    std::atomic<bool> irq_status; // raw status, shared between both interrupt lines like the INTR register
+    std::atomic<bool> busy;
+    std::atomic<bool> abort;
+    bool triggered;
+    bool has_worker;
+};
+
+static mock_dma_channel channels[NUM_DMA_CHANNELS];
+// Never destroyed: the worker threads are still waiting on these when the program exits
+static std::mutex &dma_mutex = *new std::mutex;
+static std::condition_variable &dma_trigger = *new std::condition_variable;
+static std::map<const volatile void *, mock_dma_source_t> dma_sources;
+static std::map<const volatile void *, mock_dma_sink_t> dma_sinks;
+
+static void dma_channel_worker(unsigned int channel);
+
+// Must be called with dma_mutex held
+static void dma_channel_trigger(unsigned int channel)
+{
+    mock_dma_channel &ch = channels[channel];
+    ch.busy.store(true);
+    ch.abort.store(false);
+    ch.triggered = true;
+    if (!ch.has_worker) {
+        ch.has_worker = true;
+        std::thread(dma_channel_worker, channel).detach();
+    }
+    dma_trigger.notify_all();
+}
+
+static uint32_t dma_read(const volatile void *addr, dma_channel_transfer_size size)
+{
+    auto source = dma_sources.find(addr);
+    if (source != dma_sources.end()) {
+        return source->second();
+    }
+    switch (size) {
+    case DMA_SIZE_8:
+        return *(const volatile uint8_t *)addr;
+    case DMA_SIZE_16:
+        return *(const volatile uint16_t *)addr;
+    default:
+        return *(const volatile uint32_t *)addr;
+    }
+}
+
+static void dma_write(volatile void *addr, dma_channel_transfer_size size, uint32_t data)
+{
+    auto sink = dma_sinks.find(addr);
+    if (sink != dma_sinks.end()) {
+        sink->second(data);
+        return;
+    }
+    switch (size) {
+    case DMA_SIZE_8:
+        *(volatile uint8_t *)addr = (uint8_t)data;
+        break;
+    case DMA_SIZE_16:
+        *(volatile uint16_t *)addr = (uint16_t)data;
+        break;
+    default:
+        *(volatile uint32_t *)addr = data;
+        break;
+    }
+}
+
+static void dma_channel_worker(unsigned int channel)
+{
+    mock_dma_channel &ch = channels[channel];
+    for (;;) {
+        dma_channel_config config;
+        volatile uint8_t *write_addr;
+        const volatile uint8_t *read_addr;
+        uint32_t count;
+        {
+            std::unique_lock<std::mutex> lock(dma_mutex);
+            dma_trigger.wait(lock, [&] { return ch.triggered; });
+            ch.triggered = false;
+            config = ch.config;
+            write_addr = (volatile uint8_t *)ch.write_addr;
+            read_addr = (const volatile uint8_t *)ch.read_addr;
+            count = ch.trans_count;
+        }
+
+        uint32_t stride = 1u << config.data_size;
+        for (uint32_t i = 0; i < count && !ch.abort.load(); i++) {
+            dma_write(write_addr, config.data_size, dma_read(read_addr, config.data_size));
+            read_addr += config.read_increment ? stride : 0;
+            write_addr += config.write_increment ? stride : 0;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(dma_mutex);
+            // The last transfer ends the channel's work before it raises anything, so a completion interrupt may
+            // already have set the channel up again. That new setup wins.
+            if (!ch.triggered) {
+                ch.read_addr = read_addr;
+                ch.write_addr = write_addr;
+                ch.busy.store(false);
+            }
+            if (ch.abort.load()) {
+                continue;
+            }
+            // The chain trigger fires as the channel completes, before the interrupt is serviced. Like CHAIN_TO on the
+            // real channel it is read now rather than at the trigger, so a chain broken mid-transfer never fires.
+            if (ch.config.chain_to != channel) {
+                dma_channel_trigger(ch.config.chain_to);
+            }
+        }
+        ch.irq_status.store(true);
+        if (ch.irq0_enabled) {
+            mock_irq_raise(DMA_IRQ_0);
+        }
+        if (ch.irq1_enabled) {
+            mock_irq_raise(DMA_IRQ_1);
+        }
+    }
+}
+
+int dma_claim_unused_channel(bool required)
+{
+    std::lock_guard<std::mutex> lock(dma_mutex);
+    for (unsigned int i = 0; i < NUM_DMA_CHANNELS; i++) {
+        if (!channels[i].claimed) {
+            channels[i].claimed = true;
+            return (int)i;
+        }
+    }
+    if (required) {
+        printf("Error: no DMA channels available\n");
+        abort();
+    }
+    return -1;
+}
+
+void dma_channel_unclaim(unsigned int channel)
+{
+    std::lock_guard<std::mutex> lock(dma_mutex);
+    channels[channel].claimed = false;
+}
+
+dma_channel_config dma_channel_get_default_config(unsigned int channel)
+{
+    dma_channel_config c;
+    c.data_size = DMA_SIZE_32;
+    c.read_increment = true;
+    c.write_increment = false;
+    c.dreq = 0x3f; // DREQ_FORCE
+    c.chain_to = channel;
+    return c;
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size)
+{
+    c->data_size = size;
+}
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incr)
+{
+    c->read_increment = incr;
+}
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incr)
+{
+    c->write_increment = incr;
+}
+
+void channel_config_set_dreq(dma_channel_config *c, unsigned int dreq)
+{
+    c->dreq = dreq;
+}
+
+void channel_config_set_chain_to(dma_channel_config *c, unsigned int chain_to)
+{
+    c->chain_to = chain_to;
+}
+
+void dma_channel_configure(unsigned int channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, unsigned int transfer_count, bool trigger)
+{
+    std::lock_guard<std::mutex> lock(dma_mutex);
+    mock_dma_channel &ch = channels[channel];
+    ch.config = *config;
+    ch.write_addr = write_addr;
+    ch.read_addr = read_addr;
+    ch.trans_count = transfer_count;
+    if (trigger) {
+        dma_channel_trigger(channel);
+    }
+}
+
+void dma_channel_set_read_addr(unsigned int channel, const volatile void *read_addr, bool trigger)
+{
+    std::lock_guard<std::mutex> lock(dma_mutex);
+    channels[channel].read_addr = read_addr;
+    if (trigger) {
+        dma_channel_trigger(channel);
+    }
+}
+
+void dma_channel_set_write_addr(unsigned int channel, volatile void *write_addr, bool trigger)
+{
+    std::lock_guard<std::mutex> lock(dma_mutex);
+    channels[channel].write_addr = write_addr;
+    if (trigger) {
+        dma_channel_trigger(channel);
+    }
+}
+
+void dma_channel_set_trans_count(unsigned int channel, uint32_t trans_count, bool trigger)
+{
+    std::lock_guard<std::mutex> lock(dma_mutex);
+    channels[channel].trans_count = trans_count;
+    if (trigger) {
+        dma_channel_trigger(channel);
+    }
+}
+
+void dma_channel_start(unsigned int channel)
+{
+    std::lock_guard<std::mutex> lock(dma_mutex);
+    dma_channel_trigger(channel);
+}
+
+void dma_start_channel_mask(uint32_t chan_mask)
+{
+    std::lock_guard<std::mutex> lock(dma_mutex);
+    for (unsigned int channel = 0; channel < NUM_DMA_CHANNELS; channel++) {
+        if (chan_mask & (1u << channel)) {
+            dma_channel_trigger(channel);
+        }
+    }
+}
+
+void dma_channel_abort(unsigned int channel)
+{
+    channels[channel].abort.store(true);
+    while (channels[channel].busy.load()) {
+        std::this_thread::yield();
+    }
+}
+
+bool dma_channel_is_busy(unsigned int channel)
+{
+    return channels[channel].busy.load();
+}
+
+void dma_channel_wait_for_finish_blocking(unsigned int channel)
+{
+    while (dma_channel_is_busy(channel)) {
+        std::this_thread::yield();
+    }
+}
+
+void dma_channel_set_irq0_enabled(unsigned int channel, bool enabled)
+{
+    channels[channel].irq0_enabled = enabled;
+}
+
+void dma_channel_set_irq1_enabled(unsigned int channel, bool enabled)
+{
+    channels[channel].irq1_enabled = enabled;
+}
+
+bool dma_channel_get_irq0_status(unsigned int channel)
+{
+    return channels[channel].irq0_enabled && channels[channel].irq_status.load();
+}
+
+bool dma_channel_get_irq1_status(unsigned int channel)
+{
+    return channels[channel].irq1_enabled && channels[channel].irq_status.load();
+}
+
+void dma_channel_acknowledge_irq0(unsigned int channel)
+{
+    channels[channel].irq_status.store(false);
+}
+
+void dma_channel_acknowledge_irq1(unsigned int channel)
+{
+    channels[channel].irq_status.store(false);
+}
+
+void mock_dma_register_source(const volatile void *addr, mock_dma_source_t source)
+{
+    std::lock_guard<std::mutex> lock(dma_mutex);
+    dma_sources[addr] = source;
+}
+
+void mock_dma_register_sink(const volatile void *addr, mock_dma_sink_t sink)
+{
+    std::lock_guard<std::mutex> lock(dma_mutex);
+    dma_sinks[addr] = sink;
+}
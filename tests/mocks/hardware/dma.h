@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+
+#define NUM_DMA_CHANNELS 12
+
+enum dma_channel_transfer_size {
+    DMA_SIZE_8 = 0,
+    DMA_SIZE_16 = 1,
+    DMA_SIZE_32 = 2
+};
+
+// Types defined just so that we can replicate the real API
+typedef struct {
+    enum dma_channel_transfer_size data_size;
+    bool read_increment;
+    bool write_increment;
+    unsigned int dreq;
+    unsigned int chain_to;
+} dma_channel_config;
+
+// Functions defined to replicate the real API
+int dma_claim_unused_channel(bool required);
+void dma_channel_unclaim(unsigned int channel);
+dma_channel_config dma_channel_get_default_config(unsigned int channel);
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size);
+void channel_config_set_read_increment(dma_channel_config *c, bool incr);
+void channel_config_set_write_increment(dma_channel_config *c, bool incr);
+void channel_config_set_dreq(dma_channel_config *c, unsigned int dreq);
+void channel_config_set_chain_to(dma_channel_config *c, unsigned int chain_to);
+void dma_channel_configure(unsigned int channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, unsigned int transfer_count, bool trigger);
+void dma_channel_set_read_addr(unsigned int channel, const volatile void *read_addr, bool trigger);
+void dma_channel_set_write_addr(unsigned int channel, volatile void *write_addr, bool trigger);
+void dma_channel_set_trans_count(unsigned int channel, uint32_t trans_count, bool trigger);
+void dma_channel_start(unsigned int channel);
+void dma_start_channel_mask(uint32_t chan_mask);
+void dma_channel_abort(unsigned int channel);
+bool dma_channel_is_busy(unsigned int channel);
+void dma_channel_wait_for_finish_blocking(unsigned int channel);
+void dma_channel_set_irq0_enabled(unsigned int channel, bool enabled);
+void dma_channel_set_irq1_enabled(unsigned int channel, bool enabled);
+bool dma_channel_get_irq0_status(unsigned int channel);
+bool dma_channel_get_irq1_status(unsigned int channel);
+void dma_channel_acknowledge_irq0(unsigned int channel);
+void dma_channel_acknowledge_irq1(unsigned int channel);
+
+// Test harness: peripheral registers. Reads from a registered source address call the source function instead of
+// reading memory, and writes to a registered sink address call the sink function. This is how the mocked ADC, PIO
+// and I2C blocks see DMA traffic.
+typedef uint32_t (*mock_dma_source_t)(void);
+typedef void (*mock_dma_sink_t)(uint32_t data);
+void mock_dma_register_source(const volatile void *addr, mock_dma_source_t source);
+void mock_dma_register_sink(const volatile void *addr, mock_dma_sink_t sink);
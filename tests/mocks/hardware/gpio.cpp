@@ -1,4 +1,17 @@
 #include <iostream>
+#include <atomic>
+#include <mutex>
+#include "hardware/gpio.h"
+
+#define MOCK_GPIO_COUNT 30
+
+static std::atomic<bool> gpio_levels[MOCK_GPIO_COUNT];
+static uint32_t gpio_irq_enabled[MOCK_GPIO_COUNT];   // Events that raise the interrupt
+static uint32_t gpio_irq_latched[MOCK_GPIO_COUNT];   // Edges seen and not yet acknowledged
+static std::recursive_mutex gpio_irq_mutex;
+static std::atomic<mock_gpio_output_callback_t> gpio_output_callbacks[MOCK_GPIO_COUNT];
+static gpio_irq_callback_t gpio_irq_callback;          // Shared callback, or null before it is first set
+static uint32_t gpio_callback_pins;                    // Pins whose events go to the shared callback
 
 void gpio_init(unsigned int gpio)
 {
@@ -13,5 +26,116 @@ void gpio_set_dir(unsigned int gpio, bool out)
 
 void gpio_put(unsigned int gpio, bool val)
 {
-    printf("Debug: GPIO pin %u set to %i\n", gpio, val);
+    gpio_levels[gpio] = val;
+    mock_gpio_output_callback_t callback = gpio_output_callbacks[gpio];
+    if (callback != nullptr) {
+        callback(gpio, val);
+    } else {
+        printf("Debug: GPIO pin %u set to %i\n", gpio, val);
+    }
+}
+
+bool gpio_get(unsigned int gpio)
+{
+    return gpio_levels[gpio];
+}
+
+void gpio_set_function(unsigned int gpio, unsigned int fn)
+{
+    printf("Debug: GPIO pin %u set to function %u\n", gpio, fn);
+}
+
+void gpio_pull_up(unsigned int gpio)
+{
+}
+
+void gpio_pull_down(unsigned int gpio)
+{
+}
+
+void gpio_disable_pulls(unsigned int gpio)
+{
+}
+
+void gpio_set_irq_enabled(unsigned int gpio, uint32_t event_mask, bool enabled)
+{
+    std::lock_guard<std::recursive_mutex> guard(gpio_irq_mutex);
+    gpio_irq_latched[gpio] &= ~event_mask; // Enabling clears any stale edges, as the SDK does
+    gpio_irq_enabled[gpio] = enabled ? (gpio_irq_enabled[gpio] | event_mask) : (gpio_irq_enabled[gpio] & ~event_mask);
+}
+
+void gpio_add_raw_irq_handler(unsigned int gpio, irq_handler_t handler)
+{
+    irq_add_shared_handler(IO_IRQ_BANK0, handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+}
+
+void gpio_remove_raw_irq_handler(unsigned int gpio, irq_handler_t handler)
+{
+    irq_remove_handler(IO_IRQ_BANK0, handler);
+}
+
+// The SDK's own IO_IRQ_BANK0 handler, calling the shared callback for each pin with events
+static void gpio_default_irq_handler()
+{
+    std::lock_guard<std::recursive_mutex> guard(gpio_irq_mutex);
+    for (unsigned int gpio = 0; gpio < MOCK_GPIO_COUNT; gpio++) {
+        if ((gpio_callback_pins & (1u << gpio)) == 0) {
+            continue;
+        }
+        uint32_t events = gpio_get_irq_event_mask(gpio);
+        if (events != 0) {
+            gpio_acknowledge_irq(gpio, events);
+            gpio_irq_callback(gpio, events);
+        }
+    }
+}
+
+void gpio_set_irq_enabled_with_callback(unsigned int gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback)
+{
+    std::lock_guard<std::recursive_mutex> guard(gpio_irq_mutex);
+    if (gpio_irq_callback == nullptr) {
+        irq_add_shared_handler(IO_IRQ_BANK0, gpio_default_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    }
+    gpio_irq_callback = callback;
+    gpio_callback_pins |= 1u << gpio;
+    gpio_set_irq_enabled(gpio, event_mask, enabled);
+    irq_set_enabled(IO_IRQ_BANK0, true);
+}
+
+uint32_t gpio_get_irq_event_mask(unsigned int gpio)
+{
+    std::lock_guard<std::recursive_mutex> guard(gpio_irq_mutex);
+    uint32_t levels = gpio_levels[gpio] ? GPIO_IRQ_LEVEL_HIGH : GPIO_IRQ_LEVEL_LOW;
+    return (gpio_irq_latched[gpio] | levels) & gpio_irq_enabled[gpio];
+}
+
+void gpio_acknowledge_irq(unsigned int gpio, uint32_t event_mask)
+{
+    std::lock_guard<std::recursive_mutex> guard(gpio_irq_mutex);
+    gpio_irq_latched[gpio] &= ~event_mask;
+}
+
+void mock_gpio_set_input(unsigned int gpio, bool level)
+{
+    bool raise;
+    {
+        std::lock_guard<std::recursive_mutex> guard(gpio_irq_mutex);
+        bool previous = gpio_levels[gpio].exchange(level);
+        uint32_t events = level ? GPIO_IRQ_LEVEL_HIGH : GPIO_IRQ_LEVEL_LOW;
+        if (level != previous) {
+            uint32_t edge = level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+            gpio_irq_latched[gpio] |= edge;
+            events |= edge;
+        }
+        // Edges latched earlier have already raised the interrupt
+        raise = (events & gpio_irq_enabled[gpio]) != 0;
+    }
+    if (raise) {
+        mock_irq_raise(IO_IRQ_BANK0);
+    }
+}
+
+void mock_gpio_set_output_callback(unsigned int gpio, mock_gpio_output_callback_t callback)
+{
+    gpio_output_callbacks[gpio] = callback;
 }
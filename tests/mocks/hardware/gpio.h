@@ -1,8 +1,44 @@
 #pragma once 
 
+#include <stdint.h>
+#include "hardware/irq.h"
+
 // GPIO functionality
 #define GPIO_OUT 1
 #define GPIO_IN 0
+#define GPIO_FUNC_SPI 1
+#define GPIO_FUNC_UART 2
+#define GPIO_FUNC_I2C 3
+#define GPIO_FUNC_SIO 5
 void gpio_init(unsigned int gpio);
 void gpio_set_dir(unsigned int gpio, bool out);
 void gpio_put(unsigned int gpio, bool val);
+bool gpio_get(unsigned int gpio);
+void gpio_set_function(unsigned int gpio, unsigned int fn);
+void gpio_pull_up(unsigned int gpio);
+void gpio_pull_down(unsigned int gpio);
+void gpio_disable_pulls(unsigned int gpio);
+
+// GPIO interrupts
+#define GPIO_IRQ_LEVEL_LOW 0x1u
+#define GPIO_IRQ_LEVEL_HIGH 0x2u
+#define GPIO_IRQ_EDGE_FALL 0x4u
+#define GPIO_IRQ_EDGE_RISE 0x8u
+void gpio_set_irq_enabled(unsigned int gpio, uint32_t event_mask, bool enabled);
+void gpio_add_raw_irq_handler(unsigned int gpio, irq_handler_t handler);
+void gpio_remove_raw_irq_handler(unsigned int gpio, irq_handler_t handler);
+uint32_t gpio_get_irq_event_mask(unsigned int gpio);
+void gpio_acknowledge_irq(unsigned int gpio, uint32_t event_mask);
+
+// The SDK's callback shared by every pin without a raw handler. Edges are acknowledged before it is called.
+typedef void (*gpio_irq_callback_t)(unsigned int gpio, uint32_t event_mask);
+void gpio_set_irq_enabled_with_callback(unsigned int gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback);
+
+// Test harness: drive an input pin from outside, as a sensor would. Edges are latched and IO_IRQ_BANK0 is raised for
+// any enabled event, like the real pads.
+void mock_gpio_set_input(unsigned int gpio, bool level);
+
+// Test harness: called after firmware drives `gpio` with `gpio_put()`, so a mocked device can follow its chip select.
+// One callback per pin, or nullptr to remove it. Pins with a callback are not logged, as they change too often.
+typedef void (*mock_gpio_output_callback_t)(unsigned int gpio, bool level);
+void mock_gpio_set_output_callback(unsigned int gpio, mock_gpio_output_callback_t callback);
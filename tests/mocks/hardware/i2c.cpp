@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+#define MOCK_I2C_COUNT 2
+#define MOCK_I2C_RX_FIFO_SIZE 256 // Deeper than the real 16 bytes, so the DMA never has to hold the bus
+
+// State of the transfer that a DMA channel is feeding through the data_cmd register
+struct mock_i2c_bus {
+    mock_i2c_device *device; // Addressed device, while in_transfer
+    bool in_transfer;
+    bool reading;
+    uint8_t rx_fifo[MOCK_I2C_RX_FIFO_SIZE];
+    uint32_t rx_head;
+    uint32_t rx_tail;
+    uint32_t pending_events;     // Interrupt flags waiting for the interrupt thread
+    uint32_t transfer_count;
+    bool has_irq_thread;
+};
+
+// Plain arrays, so devices can be attached by constructors of other static objects
+static i2c_hw_t i2c_hw_blocks[MOCK_I2C_COUNT];
+static mock_i2c_device *i2c_devices[MOCK_I2C_COUNT][128];
+static mock_i2c_bus i2c_buses[MOCK_I2C_COUNT];
+// Never destroyed: the DMA workers and interrupt threads are still waiting on these when the program exits
+static std::mutex &i2c_mutex = *new std::mutex;
+static std::condition_variable &i2c_changed = *new std::condition_variable;
+
+i2c_inst_t i2c0_inst = {&i2c_hw_blocks[0], false};
+i2c_inst_t i2c1_inst = {&i2c_hw_blocks[1], false};
+
+// Raise the I2C interrupt for each batch of flags, from a thread of its own as the block runs independently of the
+// DMA. The mock cannot see reads of the clear registers, so the flags are cleared once the handlers have returned,
+// with other handlers held off so none of them sees stale flags.
+static void i2c_irq_thread(unsigned int index)
+{
+    mock_i2c_bus &bus = i2c_buses[index];
+    i2c_hw_t &hw = i2c_hw_blocks[index];
+    for (;;) {
+        uint32_t events;
+        {
+            std::unique_lock<std::mutex> lock(i2c_mutex);
+            i2c_changed.wait(lock, [&] { return bus.pending_events != 0; });
+            events = bus.pending_events;
+            bus.pending_events = 0;
+        }
+        mock_irq_lock();
+        hw.raw_intr_stat = events;
+        hw.intr_stat = events & hw.intr_mask;
+        if (hw.intr_stat != 0) {
+            mock_irq_raise(I2C0_IRQ + index);
+        }
+        hw.intr_stat = 0;
+        hw.raw_intr_stat = 0;
+        mock_irq_unlock();
+    }
+}
+
+// One command word written to data_cmd. Must be called with i2c_mutex held.
+static void i2c_bus_command(unsigned int index, uint32_t command)
+{
+    mock_i2c_bus &bus = i2c_buses[index];
+    i2c_hw_t &hw = i2c_hw_blocks[index];
+    if (!(hw.enable & 1)) {
+        return; // Writes to a disabled block are dropped, as on the real one
+    }
+
+    bool read = command & I2C_IC_DATA_CMD_CMD_BITS;
+    if (!bus.in_transfer) {
+        bus.transfer_count++;
+        bus.device = i2c_devices[index][hw.tar & 0x7F];
+        bus.rx_head = bus.rx_tail = 0;
+        if (bus.device == nullptr) {
+            // Address not acknowledged. The real block flushes its FIFO and holds it until the abort is cleared;
+            // here it disables itself instead, dropping the rest of the transfer until the driver enables it again.
+            hw.tx_abrt_source = I2C_IC_TX_ABRT_SOURCE_ABRT_7B_ADDR_NOACK_BITS;
+            hw.enable = 0;
+            bus.pending_events |= I2C_IC_INTR_STAT_R_TX_ABRT_BITS | I2C_IC_INTR_STAT_R_STOP_DET_BITS;
+            i2c_changed.notify_all();
+            return;
+        }
+        bus.in_transfer = true;
+        bus.reading = read;
+        bus.device->start();
+    } else if ((command & I2C_IC_DATA_CMD_RESTART_BITS) || read != bus.reading) {
+        bus.reading = read;
+        bus.device->start();
+    }
+
+    if (read) {
+        bus.rx_fifo[bus.rx_head++ % MOCK_I2C_RX_FIFO_SIZE] = bus.device->read();
+    } else {
+        bus.device->write((uint8_t)command);
+    }
+    if (command & I2C_IC_DATA_CMD_STOP_BITS) {
+        bus.device->stop();
+        bus.in_transfer = false;
+        bus.pending_events |= I2C_IC_INTR_STAT_R_STOP_DET_BITS;
+    }
+    i2c_changed.notify_all();
+}
+
+// Writes of data_cmd by the DMA mock
+template <unsigned int INDEX>
+static void i2c_data_cmd_write(uint32_t command)
+{
+    std::lock_guard<std::mutex> lock(i2c_mutex);
+    i2c_bus_command(INDEX, command);
+}
+
+// Reads of data_cmd by the DMA mock wait for a byte to arrive, like a channel paced by the RX DREQ. After an abort
+// they return 0, so the channel can be stopped.
+template <unsigned int INDEX>
+static uint32_t i2c_data_cmd_read()
+{
+    mock_i2c_bus &bus = i2c_buses[INDEX];
+    std::unique_lock<std::mutex> lock(i2c_mutex);
+    i2c_changed.wait(lock, [&] { return bus.rx_tail != bus.rx_head || !(i2c_hw_blocks[INDEX].enable & 1); });
+    if (bus.rx_tail == bus.rx_head) {
+        return 0;
+    }
+    return bus.rx_fifo[bus.rx_tail++ % MOCK_I2C_RX_FIFO_SIZE];
+}
+
+unsigned int i2c_init(i2c_inst_t *i2c, unsigned int baudrate)
+{
+    unsigned int index = i2c_hw_index(i2c);
+    {
+        std::lock_guard<std::mutex> lock(i2c_mutex);
+        i2c->hw->enable = 1;
+        i2c->restart_on_next = false;
+        if (!i2c_buses[index].has_irq_thread) {
+            i2c_buses[index].has_irq_thread = true;
+            std::thread(i2c_irq_thread, index).detach();
+        }
+    }
+    if (index == 0) {
+        mock_dma_register_sink(&i2c->hw->data_cmd, i2c_data_cmd_write<0>);
+        mock_dma_register_source(&i2c->hw->data_cmd, i2c_data_cmd_read<0>);
+    } else {
+        mock_dma_register_sink(&i2c->hw->data_cmd, i2c_data_cmd_write<1>);
+        mock_dma_register_source(&i2c->hw->data_cmd, i2c_data_cmd_read<1>);
+    }
+    printf("Debug: I2C%u initialised at %u Hz\n", index, baudrate);
+    return baudrate;
+}
+
+void i2c_deinit(i2c_inst_t *i2c)
+{
+    std::lock_guard<std::mutex> lock(i2c_mutex);
+    i2c->hw->enable = 0;
+    i2c_changed.notify_all();
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop)
+{
+    unsigned int index = i2c_hw_index(i2c);
+    std::lock_guard<std::mutex> lock(i2c_mutex);
+    i2c_buses[index].transfer_count++;
+    mock_i2c_device *device = i2c_devices[index][addr & 0x7F];
+    if (device == nullptr) {
+        return PICO_ERROR_GENERIC;
+    }
+    device->start();
+    for (size_t i = 0; i < len; i++) {
+        device->write(src[i]);
+    }
+    if (!nostop) {
+        device->stop();
+    }
+    i2c->restart_on_next = nostop;
+    return (int)len;
+}
+
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop)
+{
+    unsigned int index = i2c_hw_index(i2c);
+    std::lock_guard<std::mutex> lock(i2c_mutex);
+    i2c_buses[index].transfer_count++;
+    mock_i2c_device *device = i2c_devices[index][addr & 0x7F];
+    if (device == nullptr) {
+        return PICO_ERROR_GENERIC;
+    }
+    device->start();
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = device->read();
+    }
+    if (!nostop) {
+        device->stop();
+    }
+    i2c->restart_on_next = nostop;
+    return (int)len;
+}
+
+unsigned int i2c_hw_index(i2c_inst_t *i2c)
+{
+    return (i2c == i2c1) ? 1 : 0;
+}
+
+i2c_hw_t *i2c_get_hw(i2c_inst_t *i2c)
+{
+    return i2c->hw;
+}
+
+unsigned int i2c_get_dreq(i2c_inst_t *i2c, bool is_tx)
+{
+    return DREQ_I2C0_TX + i2c_hw_index(i2c) * 2 + (is_tx ? 0 : 1);
+}
+
+void mock_i2c_attach(i2c_inst_t *i2c, uint8_t addr, mock_i2c_device *device)
+{
+    i2c_devices[i2c_hw_index(i2c)][addr & 0x7F] = device;
+}
+
+uint32_t mock_i2c_get_transfer_count(i2c_inst_t *i2c)
+{
+    std::lock_guard<std::mutex> lock(i2c_mutex);
+    return i2c_buses[i2c_hw_index(i2c)].transfer_count;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "hardware/irq.h"
+
+// Register block, with the registers that drivers use to run transfers by DMA
+typedef struct {
+    volatile uint32_t con;
+    volatile uint32_t tar;
+    volatile uint32_t data_cmd;
+    volatile uint32_t intr_stat;
+    volatile uint32_t intr_mask;
+    volatile uint32_t raw_intr_stat;
+    volatile uint32_t clr_intr;
+    volatile uint32_t clr_tx_abrt;
+    volatile uint32_t clr_stop_det;
+    volatile uint32_t enable;
+    volatile uint32_t tx_abrt_source;
+    volatile uint32_t dma_cr;
+} i2c_hw_t;
+
+#define I2C_IC_DATA_CMD_CMD_BITS 0x00000100u
+#define I2C_IC_DATA_CMD_STOP_BITS 0x00000200u
+#define I2C_IC_DATA_CMD_RESTART_BITS 0x00000400u
+#define I2C_IC_INTR_STAT_R_TX_ABRT_BITS 0x00000040u
+#define I2C_IC_INTR_STAT_R_STOP_DET_BITS 0x00000200u
+#define I2C_IC_INTR_MASK_M_TX_ABRT_BITS 0x00000040u
+#define I2C_IC_INTR_MASK_M_STOP_DET_BITS 0x00000200u
+#define I2C_IC_TX_ABRT_SOURCE_ABRT_7B_ADDR_NOACK_BITS 0x00000001u
+#define I2C_IC_DMA_CR_RDMAE_BITS 0x00000001u
+#define I2C_IC_DMA_CR_TDMAE_BITS 0x00000002u
+
+#define DREQ_I2C0_TX 32
+#define DREQ_I2C0_RX 33
+#define DREQ_I2C1_TX 34
+#define DREQ_I2C1_RX 35
+
+// Types defined just so that we can replicate the real API
+typedef struct i2c_inst {
+    i2c_hw_t *hw;
+    bool restart_on_next;
+} i2c_inst_t;
+
+extern i2c_inst_t i2c0_inst;
+extern i2c_inst_t i2c1_inst;
+#define i2c0 (&i2c0_inst)
+#define i2c1 (&i2c1_inst)
+
+// Functions defined to replicate the real API
+unsigned int i2c_init(i2c_inst_t *i2c, unsigned int baudrate);
+void i2c_deinit(i2c_inst_t *i2c);
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop);
+unsigned int i2c_hw_index(i2c_inst_t *i2c);
+i2c_hw_t *i2c_get_hw(i2c_inst_t *i2c);
+unsigned int i2c_get_dreq(i2c_inst_t *i2c, bool is_tx);
+
+// Test harness: a device on the bus. The bus calls `start()` on every START or repeated START addressed to the
+// device, then `write()` or `read()` once per byte, then `stop()`. Calls may come from any thread, one at a time.
+class mock_i2c_device {
+public:
+    virtual ~mock_i2c_device() = default;
+    virtual void start() {}
+    virtual void write(uint8_t data) = 0;
+    virtual uint8_t read() = 0;
+    virtual void stop() {}
+};
+
+// Test harness: connect a device at a 7-bit address, or disconnect it with nullptr. Transfers to an address with no
+// device are not acknowledged: the blocking functions return PICO_ERROR_GENERIC and DMA transfers abort.
+void mock_i2c_attach(i2c_inst_t *i2c, uint8_t addr, mock_i2c_device *device);
+
+// Test harness: count every transfer started on the bus, blocking or by DMA
+uint32_t mock_i2c_get_transfer_count(i2c_inst_t *i2c);
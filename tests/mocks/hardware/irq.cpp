@@ -0,0 +1,64 @@
+#include <stdint.h>
+#include <vector>
+#include <mutex>
+#include <algorithm>
+#include "hardware/irq.h"
+
+#define NUM_IRQS 32
+
+static std::vector<irq_handler_t> irq_handlers[NUM_IRQS];
+static bool irq_enabled[NUM_IRQS];
+static std::recursive_mutex irq_mutex; // only one "interrupt" runs at a time
+
+void irq_set_exclusive_handler(unsigned int num, irq_handler_t handler)
+{
+    std::lock_guard<std::recursive_mutex> guard(irq_mutex);
+    irq_handlers[num].clear();
+    irq_handlers[num].push_back(handler);
+}
+
+void irq_add_shared_handler(unsigned int num, irq_handler_t handler, uint8_t order_priority)
+{
+    std::lock_guard<std::recursive_mutex> guard(irq_mutex);
+    irq_handlers[num].push_back(handler);
+}
+
+void irq_remove_handler(unsigned int num, irq_handler_t handler)
+{
+    std::lock_guard<std::recursive_mutex> guard(irq_mutex);
+    auto &handlers = irq_handlers[num];
+    handlers.erase(std::remove(handlers.begin(), handlers.end(), handler), handlers.end());
+}
+
+void irq_set_enabled(unsigned int num, bool enabled)
+{
+    std::lock_guard<std::recursive_mutex> guard(irq_mutex);
+    irq_enabled[num] = enabled;
+}
+
+// Software triggered interrupts run straight away on the calling thread, as they would preempt it on the real core
+void irq_set_pending(unsigned int num)
+{
+    mock_irq_raise(num);
+}
+
+void mock_irq_raise(unsigned int num)
+{
+    std::lock_guard<std::recursive_mutex> guard(irq_mutex);
+    if (!irq_enabled[num]) {
+        return;
+    }
+    for (irq_handler_t handler : irq_handlers[num]) {
+        handler();
+    }
+}
+
+void mock_irq_lock()
+{
+    irq_mutex.lock();
+}
+
+void mock_irq_unlock()
+{
+    irq_mutex.unlock();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+// Interrupt numbers used by the drivers
+#define DMA_IRQ_0 11
+#define DMA_IRQ_1 12
+#define IO_IRQ_BANK0 13
+#define I2C0_IRQ 23
+#define I2C1_IRQ 24
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+
+typedef void (*irq_handler_t)(void);
+
+// Functions defined to replicate the real API
+void irq_set_exclusive_handler(unsigned int num, irq_handler_t handler);
+void irq_add_shared_handler(unsigned int num, irq_handler_t handler, uint8_t order_priority);
+void irq_remove_handler(unsigned int num, irq_handler_t handler);
+void irq_set_enabled(unsigned int num, bool enabled);
+void irq_set_pending(unsigned int num);
+
+// Test harness: run the handlers attached to an interrupt, as the NVIC would. Handlers are serialised so that
+// interrupt code never runs concurrently with itself, just like on a single core.
+void mock_irq_raise(unsigned int num);
+
+// Test harness: hold off every interrupt handler, so that a mocked peripheral can change its registers, raise its
+// interrupt and clear them again without another handler seeing them half way. Nests.
+void mock_irq_lock();
+void mock_irq_unlock();
@@ -1,18 +1,116 @@
+#include <stdio.h>
+#include <stdlib.h>
 #include <vector>
 #include "hardware/pio.h"
+#include "hardware/dma.h"
 
-PIO pio0 = 0;
-static std::vector<pio_program_t> pio_programs;
+#define DREQ_PIO0_TX0 0
+#define DREQ_PIO0_RX0 4
+#define DREQ_PIO1_TX0 8
+#define DREQ_PIO1_RX0 12
+#define MOCK_PIO_MAX_PROGRAMS 8 // 32 instructions of memory, and the ws2812 program takes 4
+
+static pio_hw_t mock_pio_hw[NUM_PIOS];
+PIO pio0 = &mock_pio_hw[0];
+PIO pio1 = &mock_pio_hw[1];
+
+struct mock_pio_state {
+    std::vector<pio_program_t> programs; // Indexed by offset
+    pio_program_t sm_programs[NUM_PIO_STATE_MACHINES] = {};
+    bool sm_claimed[NUM_PIO_STATE_MACHINES] = {};
+    bool sinks_registered = false;
+};
+static mock_pio_state pio_state[NUM_PIOS];
+
+// Words written to a TX FIFO by the DMA are delivered exactly like pio_sm_put_blocking
+template <unsigned int PIO_INDEX, unsigned int SM>
+static void pio_tx_fifo_write(uint32_t data)
+{
+    pio_sm_put_blocking(&mock_pio_hw[PIO_INDEX], SM, data);
+}
+
+template <unsigned int PIO_INDEX>
+static void pio_register_sinks()
+{
+    mock_dma_register_sink(&mock_pio_hw[PIO_INDEX].txf[0], pio_tx_fifo_write<PIO_INDEX, 0>);
+    mock_dma_register_sink(&mock_pio_hw[PIO_INDEX].txf[1], pio_tx_fifo_write<PIO_INDEX, 1>);
+    mock_dma_register_sink(&mock_pio_hw[PIO_INDEX].txf[2], pio_tx_fifo_write<PIO_INDEX, 2>);
+    mock_dma_register_sink(&mock_pio_hw[PIO_INDEX].txf[3], pio_tx_fifo_write<PIO_INDEX, 3>);
+}
+
+unsigned int pio_get_index(PIO pio)
+{
+    return (unsigned int)(pio - mock_pio_hw);
+}
 
 unsigned int pio_add_program(PIO pio, const pio_program_t* program)
 {
-    pio_programs.push_back(*program);
-    return 0;
+    mock_pio_state &state = pio_state[pio_get_index(pio)];
+    if (!state.sinks_registered) {
+        if (pio == pio0) {
+            pio_register_sinks<0>();
+        } else {
+            pio_register_sinks<1>();
+        }
+        state.sinks_registered = true;
+    }
+    // Like the real PIO, instruction memory runs out if programs keep being added
+    if (state.programs.size() >= MOCK_PIO_MAX_PROGRAMS) {
+        fprintf(stderr, "Mock PIO: no program space on PIO %u\n", pio_get_index(pio));
+        abort();
+    }
+    state.programs.push_back(*program);
+    return (unsigned int)state.programs.size() - 1;
+}
+
+void pio_sm_init(PIO pio, unsigned int sm, unsigned int initial_pc, const pio_sm_config *config)
+{
+    mock_pio_state &state = pio_state[pio_get_index(pio)];
+    state.sm_programs[sm] = initial_pc < state.programs.size() ? state.programs[initial_pc] : nullptr;
+}
+
+void pio_sm_set_enabled(PIO pio, unsigned int sm, bool enabled)
+{
+}
+
+int pio_claim_unused_sm(PIO pio, bool required)
+{
+    mock_pio_state &state = pio_state[pio_get_index(pio)];
+    for (unsigned int sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++) {
+        if (!state.sm_claimed[sm]) {
+            state.sm_claimed[sm] = true;
+            return (int)sm;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "Mock PIO: no free state machine on PIO %u\n", pio_get_index(pio));
+        abort();
+    }
+    return -1;
+}
+
+void pio_sm_unclaim(PIO pio, unsigned int sm)
+{
+    pio_state[pio_get_index(pio)].sm_claimed[sm] = false;
 }
 
 void pio_sm_put_blocking(PIO pio, unsigned int sm, uint32_t data)
 {
-    for (auto program : pio_programs) {
-        program(data);
+    pio_program_t program = pio_state[pio_get_index(pio)].sm_programs[sm];
+    if (program != nullptr) {
+        program(pio, sm, data);
+    }
+}
+
+unsigned int pio_get_dreq(PIO pio, unsigned int sm, bool is_tx)
+{
+    if (pio == pio0) {
+        return (is_tx ? DREQ_PIO0_TX0 : DREQ_PIO0_RX0) + sm;
     }
+    return (is_tx ? DREQ_PIO1_TX0 : DREQ_PIO1_RX0) + sm;
+}
+
+unsigned int mock_pio_get_program_count(PIO pio)
+{
+    return (unsigned int)pio_state[pio_get_index(pio)].programs.size();
 }
@@ -1,14 +1,34 @@
 #pragma once 
 
+#include <stdint.h>
 #include <vector>
 
+#define NUM_PIOS 2
+#define NUM_PIO_STATE_MACHINES 4
+
 // Types defined just so that we can replicate the real API
-typedef uint32_t PIO;
+typedef struct {
+    volatile uint32_t txf[NUM_PIO_STATE_MACHINES]; // TX FIFO of each state machine, so DMA can be pointed at it
+} pio_hw_t;
+typedef pio_hw_t *PIO;
 extern PIO pio0;
+extern PIO pio1;
+
+typedef struct {
+} pio_sm_config;
 
-// A "program" in the mock is a function pointer that is called with the data being delivered to the PIO.
-typedef void (*pio_program_t)(uint32_t data);
+// A "program" in the mock is a function pointer that is called with the data being delivered to a state machine.
+typedef void (*pio_program_t)(PIO pio, unsigned int sm, uint32_t data);
 
 // Functions defined to replicate the real API
 unsigned int pio_add_program(PIO pio, const pio_program_t* program);
+void pio_sm_init(PIO pio, unsigned int sm, unsigned int initial_pc, const pio_sm_config *config);
+void pio_sm_set_enabled(PIO pio, unsigned int sm, bool enabled);
+int pio_claim_unused_sm(PIO pio, bool required);
+void pio_sm_unclaim(PIO pio, unsigned int sm);
 void pio_sm_put_blocking(PIO pio, unsigned int sm, uint32_t data);
+unsigned int pio_get_dreq(PIO pio, unsigned int sm, bool is_tx);
+unsigned int pio_get_index(PIO pio);
+
+// Test harness: the number of programs loaded into a PIO's instruction memory
+unsigned int mock_pio_get_program_count(PIO pio);
@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <mutex>
+#include <condition_variable>
+#include "hardware/spi.h"
+#include "hardware/gpio.h"
+#include "hardware/dma.h"
+
+#define MOCK_SPI_COUNT 2
+#define MOCK_SPI_MAX_DEVICES 4
+#define MOCK_SPI_RX_FIFO_SIZE 256 // Deeper than the real 8 bytes, so the TX channel can run ahead of the RX channel
+
+struct mock_spi_bus {
+    unsigned int cs_pins[MOCK_SPI_MAX_DEVICES];
+    mock_spi_device *devices[MOCK_SPI_MAX_DEVICES];
+    mock_spi_device *selected;
+    uint8_t rx_fifo[MOCK_SPI_RX_FIFO_SIZE];
+    uint32_t rx_head;
+    uint32_t rx_tail;
+    uint32_t byte_count;
+};
+
+// Plain arrays, so devices can be attached by constructors of other static objects
+static spi_hw_t spi_hw_blocks[MOCK_SPI_COUNT];
+static mock_spi_bus spi_buses[MOCK_SPI_COUNT];
+// Never destroyed: the DMA workers are still waiting on these when the program exits
+static std::mutex &spi_mutex = *new std::mutex;
+static std::condition_variable &spi_changed = *new std::condition_variable;
+
+spi_inst_t spi0_inst = {&spi_hw_blocks[0], 0};
+spi_inst_t spi1_inst = {&spi_hw_blocks[1], 0};
+
+// Shift one byte out and one back in. Must be called with spi_mutex held.
+static uint8_t spi_bus_transfer(unsigned int index, uint8_t data)
+{
+    mock_spi_bus &bus = spi_buses[index];
+    bus.byte_count++;
+    return (bus.selected != nullptr) ? bus.selected->transfer(data) : 0xFF;
+}
+
+// A chip select pin changed: select or deselect the device wired to it
+static void spi_cs_changed(unsigned int gpio, bool level)
+{
+    std::lock_guard<std::mutex> lock(spi_mutex);
+    for (unsigned int index = 0; index < MOCK_SPI_COUNT; index++) {
+        mock_spi_bus &bus = spi_buses[index];
+        for (int i = 0; i < MOCK_SPI_MAX_DEVICES; i++) {
+            mock_spi_device *device = bus.devices[i];
+            if (device == nullptr || bus.cs_pins[i] != gpio) {
+                continue;
+            }
+            if (!level && bus.selected != device) {
+                bus.selected = device;
+                device->select();
+            } else if (level && bus.selected == device) {
+                device->deselect();
+                bus.selected = nullptr;
+            }
+        }
+    }
+}
+
+// Writes of the data register by the DMA mock: each byte sent clocks one byte into the RX FIFO
+template <unsigned int INDEX>
+static void spi_dr_write(uint32_t data)
+{
+    mock_spi_bus &bus = spi_buses[INDEX];
+    std::lock_guard<std::mutex> lock(spi_mutex);
+    bus.rx_fifo[bus.rx_head++ % MOCK_SPI_RX_FIFO_SIZE] = spi_bus_transfer(INDEX, (uint8_t)data);
+    spi_changed.notify_all();
+}
+
+// Reads of the data register by the DMA mock wait for a byte to arrive, like a channel paced by the RX DREQ
+template <unsigned int INDEX>
+static uint32_t spi_dr_read()
+{
+    mock_spi_bus &bus = spi_buses[INDEX];
+    std::unique_lock<std::mutex> lock(spi_mutex);
+    spi_changed.wait(lock, [&] { return bus.rx_tail != bus.rx_head; });
+    return bus.rx_fifo[bus.rx_tail++ % MOCK_SPI_RX_FIFO_SIZE];
+}
+
+unsigned int spi_init(spi_inst_t *spi, unsigned int baudrate)
+{
+    unsigned int index = spi_get_index(spi);
+    {
+        std::lock_guard<std::mutex> lock(spi_mutex);
+        spi->baudrate = baudrate;
+        spi_buses[index].rx_head = spi_buses[index].rx_tail = 0;
+    }
+    if (index == 0) {
+        mock_dma_register_sink(&spi->hw->dr, spi_dr_write<0>);
+        mock_dma_register_source(&spi->hw->dr, spi_dr_read<0>);
+    } else {
+        mock_dma_register_sink(&spi->hw->dr, spi_dr_write<1>);
+        mock_dma_register_source(&spi->hw->dr, spi_dr_read<1>);
+    }
+    printf("Debug: SPI%u initialised at %u Hz\n", index, baudrate);
+    return baudrate;
+}
+
+void spi_deinit(spi_inst_t *spi)
+{
+    std::lock_guard<std::mutex> lock(spi_mutex);
+    spi->baudrate = 0;
+}
+
+void spi_set_format(spi_inst_t *spi, unsigned int data_bits, spi_cpol_t cpol, spi_cpha_t cpha, spi_order_t order)
+{
+    printf("Debug: SPI%u set to %u bits, mode %u, %s first\n", spi_get_index(spi), data_bits,
+           (unsigned int)cpol * 2 + (unsigned int)cpha, order == SPI_MSB_FIRST ? "MSB" : "LSB");
+}
+
+// The blocking functions discard whatever they clock in, leaving the RX FIFO empty as the SDK does
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len)
+{
+    unsigned int index = spi_get_index(spi);
+    std::lock_guard<std::mutex> lock(spi_mutex);
+    for (size_t i = 0; i < len; i++) {
+        spi_bus_transfer(index, src[i]);
+    }
+    spi_buses[index].rx_tail = spi_buses[index].rx_head;
+    return (int)len;
+}
+
+int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len)
+{
+    unsigned int index = spi_get_index(spi);
+    std::lock_guard<std::mutex> lock(spi_mutex);
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = spi_bus_transfer(index, repeated_tx_data);
+    }
+    return (int)len;
+}
+
+int spi_write_read_blocking(spi_inst_t *spi, const uint8_t *src, uint8_t *dst, size_t len)
+{
+    unsigned int index = spi_get_index(spi);
+    std::lock_guard<std::mutex> lock(spi_mutex);
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = spi_bus_transfer(index, src[i]);
+    }
+    return (int)len;
+}
+
+unsigned int spi_get_index(const spi_inst_t *spi)
+{
+    return (spi == spi1) ? 1 : 0;
+}
+
+spi_hw_t *spi_get_hw(spi_inst_t *spi)
+{
+    return spi->hw;
+}
+
+unsigned int spi_get_dreq(spi_inst_t *spi, bool is_tx)
+{
+    return DREQ_SPI0_TX + spi_get_index(spi) * 2 + (is_tx ? 0 : 1);
+}
+
+void mock_spi_attach(spi_inst_t *spi, unsigned int cs_pin, mock_spi_device *device)
+{
+    mock_spi_bus &bus = spi_buses[spi_get_index(spi)];
+    int slot = -1;
+    for (int i = 0; i < MOCK_SPI_MAX_DEVICES; i++) {
+        if (bus.devices[i] != nullptr && bus.cs_pins[i] == cs_pin) {
+            slot = i; // Replace the device on this pin
+            break;
+        }
+        if (bus.devices[i] == nullptr && slot < 0) {
+            slot = i;
+        }
+    }
+    if (slot < 0) {
+        return;
+    }
+    if (bus.selected == bus.devices[slot]) {
+        bus.selected = nullptr;
+    }
+    bus.cs_pins[slot] = cs_pin;
+    bus.devices[slot] = device;
+    mock_gpio_set_output_callback(cs_pin, spi_cs_changed);
+}
+
+unsigned int mock_spi_get_baudrate(spi_inst_t *spi)
+{
+    std::lock_guard<std::mutex> lock(spi_mutex);
+    return spi->baudrate;
+}
+
+uint32_t mock_spi_get_byte_count(spi_inst_t *spi)
+{
+    std::lock_guard<std::mutex> lock(spi_mutex);
+    return spi_buses[spi_get_index(spi)].byte_count;
+}
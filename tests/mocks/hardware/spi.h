@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Register block, with the data register that drivers use to run transfers by DMA
+typedef struct {
+    volatile uint32_t cr0;
+    volatile uint32_t cr1;
+    volatile uint32_t dr;
+    volatile uint32_t sr;
+    volatile uint32_t cpsr;
+    volatile uint32_t imsc;
+    volatile uint32_t ris;
+    volatile uint32_t mis;
+    volatile uint32_t icr;
+    volatile uint32_t dmacr;
+} spi_hw_t;
+
+#define DREQ_SPI0_TX 16
+#define DREQ_SPI0_RX 17
+#define DREQ_SPI1_TX 18
+#define DREQ_SPI1_RX 19
+
+// Types defined just so that we can replicate the real API
+typedef struct spi_inst {
+    spi_hw_t *hw;
+    unsigned int baudrate;
+} spi_inst_t;
+
+extern spi_inst_t spi0_inst;
+extern spi_inst_t spi1_inst;
+#define spi0 (&spi0_inst)
+#define spi1 (&spi1_inst)
+
+typedef enum { SPI_CPHA_0 = 0, SPI_CPHA_1 = 1 } spi_cpha_t;
+typedef enum { SPI_CPOL_0 = 0, SPI_CPOL_1 = 1 } spi_cpol_t;
+typedef enum { SPI_LSB_FIRST = 0, SPI_MSB_FIRST = 1 } spi_order_t;
+
+// Functions defined to replicate the real API
+unsigned int spi_init(spi_inst_t *spi, unsigned int baudrate);
+void spi_deinit(spi_inst_t *spi);
+void spi_set_format(spi_inst_t *spi, unsigned int data_bits, spi_cpol_t cpol, spi_cpha_t cpha, spi_order_t order);
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len);
+int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len);
+int spi_write_read_blocking(spi_inst_t *spi, const uint8_t *src, uint8_t *dst, size_t len);
+unsigned int spi_get_index(const spi_inst_t *spi);
+spi_hw_t *spi_get_hw(spi_inst_t *spi);
+unsigned int spi_get_dreq(spi_inst_t *spi, bool is_tx);
+
+// Test harness: a device on the bus with its own chip select. The bus calls `select()` when the chip select pin is
+// driven low, `transfer()` once per byte while it is low, returning the byte shifted out on MISO, and `deselect()`
+// when it goes high again. Calls may come from any thread, one at a time.
+class mock_spi_device {
+public:
+    virtual ~mock_spi_device() = default;
+    virtual void select() {}
+    virtual uint8_t transfer(uint8_t data) = 0;
+    virtual void deselect() {}
+};
+
+// Test harness: connect a device selected by `cs_pin`, or disconnect it with nullptr. Bytes sent with no device
+// selected read back as 0xFF, as from a floating MISO with a pull-up.
+void mock_spi_attach(spi_inst_t *spi, unsigned int cs_pin, mock_spi_device *device);
+
+// Test harness: the clock rate passed to `spi_init()`, or 0 before it was called
+unsigned int mock_spi_get_baudrate(spi_inst_t *spi);
+
+// Test harness: count every byte clocked on the bus, blocking or by DMA
+uint32_t mock_spi_get_byte_count(spi_inst_t *spi);
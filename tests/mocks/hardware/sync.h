@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+#include "hardware/irq.h"
+
+// Masking interrupts holds off the mocked interrupt handlers. They are serialised by the same lock, so this also keeps
+// out handlers running for the other core, which the real mask would not.
+static inline uint32_t save_and_disable_interrupts()
+{
+    mock_irq_lock();
+    return 0;
+}
+
+static inline void restore_interrupts(uint32_t status)
+{
+    (void)status;
+    mock_irq_unlock();
+}
@@ -0,0 +1,36 @@
+#include <stdio.h>
+#include "hardware/uart.h"
+
+uart_inst_t uart0_inst = {0, 0};
+uart_inst_t uart1_inst = {1, 0};
+
+static FILE *raw_capture[2] = {stdout, stdout};
+
+unsigned int uart_init(uart_inst_t *uart, unsigned int baudrate)
+{
+    uart->baudrate = baudrate;
+    printf("Debug: UART%u initialised at %u baud\n", uart->index, baudrate);
+    return baudrate;
+}
+
+void uart_puts(uart_inst_t *uart, const char *s)
+{
+    printf("Debug: UART%u sent: %s", uart->index, s);
+}
+
+bool uart_is_writable(uart_inst_t *uart)
+{
+    return true;
+}
+
+void uart_putc_raw(uart_inst_t *uart, char c)
+{
+    if (raw_capture[uart->index] != nullptr) {
+        fputc(c, raw_capture[uart->index]);
+    }
+}
+
+void mock_uart_set_capture(uart_inst_t *uart, FILE *capture)
+{
+    raw_capture[uart->index] = capture;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Types defined just so that we can replicate the real API
+typedef struct uart_inst {
+    unsigned int index;
+    unsigned int baudrate;
+} uart_inst_t;
+
+extern uart_inst_t uart0_inst;
+extern uart_inst_t uart1_inst;
+#define uart0 (&uart0_inst)
+#define uart1 (&uart1_inst)
+
+// Functions defined to replicate the real API. Text sent is printed to the console.
+unsigned int uart_init(uart_inst_t *uart, unsigned int baudrate);
+void uart_puts(uart_inst_t *uart, const char *s);
+
+// Raw bytes are written unchanged to stdout, where printf output goes too, as both share the stdio UART on the board.
+// The transmit FIFO never fills.
+bool uart_is_writable(uart_inst_t *uart);
+void uart_putc_raw(uart_inst_t *uart, char c);
+
+// Test harness: send a UART's raw bytes to `capture` instead of stdout, or discard them if it is null
+void mock_uart_set_capture(uart_inst_t *uart, FILE *capture);
@@ -0,0 +1,292 @@
+#include <string.h>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "board.h"
+#include "hardware/i2c.h"
+#include "hardware/spi.h"
+#include "hardware/gpio.h"
+#include "lis3dh.h"
+
+#define LIS3DH_WHO_AM_I 0x0F
+#define LIS3DH_CTRL_REG1 0x20
+#define LIS3DH_CTRL_REG3 0x22
+#define LIS3DH_CTRL_REG5 0x24
+#define LIS3DH_STATUS_REG 0x27
+#define LIS3DH_OUT_X_L 0x28
+#define LIS3DH_OUT_Z_H 0x2D
+#define LIS3DH_FIFO_CTRL_REG 0x2E
+#define LIS3DH_FIFO_SRC_REG 0x2F
+#define LIS3DH_FIFO_DEPTH 32
+
+// The sensor itself, shared by the I2C and SPI interfaces below
+class mock_lis3dh {
+public:
+    mock_lis3dh()
+    {
+        memset(registers, 0, sizeof(registers));
+        registers[LIS3DH_WHO_AM_I] = 0x33;
+        registers[LIS3DH_CTRL_REG1] = 0x07; // Powered down, all axes enabled
+        latest[2] = 16000;                   // 1 g on Z at the default ±2 g scale (1 mg per 12-bit step), lying flat
+    }
+
+    // The register address sent at the start of an access
+    void begin_access(uint8_t reg, bool increment)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pointer = reg & 0x7F;
+        auto_increment = increment;
+    }
+
+    void write_next(uint8_t data)
+    {
+        bool int1;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            write_register(pointer, data);
+            advance();
+            int1 = int1_level();
+        }
+        sampling_changed.notify_all();
+        mock_gpio_set_input(ACCEL_INT1, int1);
+    }
+
+    uint8_t read_next()
+    {
+        uint8_t data;
+        bool int1;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            data = read_register(pointer);
+            advance();
+            int1 = int1_level();
+        }
+        mock_gpio_set_input(ACCEL_INT1, int1);
+        return data;
+    }
+
+    uint8_t peek(uint8_t reg)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return (reg == LIS3DH_FIFO_SRC_REG) ? fifo_source() : registers[reg & 0x7F];
+    }
+
+    void set_acceleration(int16_t x, int16_t y, int16_t z)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        next[0] = x;
+        next[1] = y;
+        next[2] = z;
+        has_next = true;
+    }
+
+private:
+    // Sample period for the ODR and LPen bits of CTRL_REG1, or 0 when powered down
+    static uint32_t sample_period_us(uint8_t ctrl_reg1)
+    {
+        static const uint32_t rates_hz[16] = {0, 1, 10, 25, 50, 100, 200, 400, 1600, 1344, 0, 0, 0, 0, 0, 0};
+        bool low_power = ctrl_reg1 & 0x08;
+        uint32_t rate = ((ctrl_reg1 >> 4) == 0b1001 && low_power) ? 5376 : rates_hz[ctrl_reg1 >> 4];
+        return rate ? 1000000 / rate : 0;
+    }
+
+    bool fifo_enabled() const
+    {
+        return (registers[LIS3DH_CTRL_REG5] & 0x40) && (registers[LIS3DH_FIFO_CTRL_REG] & 0xC0) != 0;
+    }
+
+    uint8_t fifo_source() const
+    {
+        uint8_t watermark = registers[LIS3DH_FIFO_CTRL_REG] & 0x1F;
+        return (fifo_count > watermark ? 0x80 : 0) | (fifo_count == LIS3DH_FIFO_DEPTH ? 0x40 : 0) |
+               (fifo_count == 0 ? 0x20 : 0) | (fifo_count & 0x1F);
+    }
+
+    bool int1_level() const
+    {
+        uint8_t source = fifo_source();
+        return fifo_enabled() && (((registers[LIS3DH_CTRL_REG3] & 0x04) && (source & 0x80)) ||
+                                  ((registers[LIS3DH_CTRL_REG3] & 0x02) && (source & 0x40)));
+    }
+
+    uint8_t read_register(uint8_t reg)
+    {
+        if (reg >= LIS3DH_OUT_X_L && reg <= LIS3DH_OUT_Z_H) {
+            int byte = reg - LIS3DH_OUT_X_L;
+            const int16_t *sample = (fifo_enabled() && fifo_count > 0) ? fifo[fifo_first] : latest;
+            uint8_t data = (uint8_t)(sample[byte / 2] >> ((byte & 1) * 8));
+            if (reg == LIS3DH_OUT_Z_H && fifo_enabled() && fifo_count > 0) {
+                fifo_first = (fifo_first + 1) % LIS3DH_FIFO_DEPTH; // Reading the last byte moves on to the next sample
+                fifo_count--;
+            }
+            if (reg == LIS3DH_OUT_Z_H) {
+                registers[LIS3DH_STATUS_REG] = 0;
+            }
+            return data;
+        }
+        if (reg == LIS3DH_FIFO_SRC_REG) {
+            return fifo_source();
+        }
+        return registers[reg];
+    }
+
+    void write_register(uint8_t reg, uint8_t data)
+    {
+        if (reg == LIS3DH_WHO_AM_I || reg == LIS3DH_STATUS_REG || reg == LIS3DH_FIFO_SRC_REG ||
+            (reg >= LIS3DH_OUT_X_L && reg <= LIS3DH_OUT_Z_H)) {
+            return; // Read only
+        }
+        registers[reg] = data;
+        if (!fifo_enabled()) {
+            fifo_count = 0; // Bypass mode empties the FIFO
+            fifo_first = 0;
+        }
+        if (reg == LIS3DH_CTRL_REG1 && sample_period_us(data) != 0 && !has_thread) {
+            has_thread = true;
+            std::thread([this] { sample_thread(); }).detach();
+        }
+    }
+
+    // With auto-increment the address moves on after each byte, wrapping within the outputs while the FIFO is on so
+    // one long read returns sample after sample
+    void advance()
+    {
+        if (!auto_increment) {
+            return;
+        }
+        pointer = (pointer == LIS3DH_OUT_Z_H && fifo_enabled()) ? LIS3DH_OUT_X_L : (uint8_t)((pointer + 1) & 0x7F);
+    }
+
+    void take_sample()
+    {
+        if (has_next) {
+            memcpy(latest, next, sizeof(latest));
+        }
+        registers[LIS3DH_STATUS_REG] = 0x0F; // New data on every axis
+        if (!fifo_enabled()) {
+            return;
+        }
+        bool stream = (registers[LIS3DH_FIFO_CTRL_REG] & 0xC0) == 0x80;
+        if (fifo_count == LIS3DH_FIFO_DEPTH) {
+            if (!stream) {
+                return; // FIFO mode stops collecting once full
+            }
+            fifo_first = (fifo_first + 1) % LIS3DH_FIFO_DEPTH; // Stream mode drops the oldest sample
+            fifo_count--;
+        }
+        memcpy(fifo[(fifo_first + fifo_count) % LIS3DH_FIFO_DEPTH], latest, sizeof(latest));
+        fifo_count++;
+    }
+
+    void sample_thread()
+    {
+        auto next_sample = std::chrono::steady_clock::now();
+        for (;;) {
+            bool int1;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                sampling_changed.wait(lock, [&] { return sample_period_us(registers[LIS3DH_CTRL_REG1]) != 0; });
+                next_sample += std::chrono::microseconds(sample_period_us(registers[LIS3DH_CTRL_REG1]));
+            }
+            std::this_thread::sleep_until(next_sample);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                take_sample();
+                int1 = int1_level();
+            }
+            mock_gpio_set_input(ACCEL_INT1, int1);
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable sampling_changed;
+    uint8_t registers[128];
+    uint8_t pointer = 0;
+    bool auto_increment = false;
+    int16_t latest[3] = {0, 0, 0};
+    int16_t next[3] = {0, 0, 0};
+    bool has_next = false;
+    int16_t fifo[LIS3DH_FIFO_DEPTH][3];
+    int fifo_first = 0;
+    int fifo_count = 0;
+    bool has_thread = false;
+};
+
+// Never destroyed: the sampling thread is still running when the program exits
+static mock_lis3dh &sensor = *new mock_lis3dh;
+
+// I2C: the first byte written after a START is the register address, with auto-increment in bit 7
+class mock_lis3dh_i2c : public mock_i2c_device {
+public:
+    void start() override { expect_address = true; }
+
+    void write(uint8_t data) override
+    {
+        if (expect_address) {
+            expect_address = false;
+            sensor.begin_access(data & 0x7F, data & 0x80);
+            return;
+        }
+        sensor.write_next(data);
+    }
+
+    uint8_t read() override { return sensor.read_next(); }
+
+private:
+    bool expect_address = false;
+};
+
+// SPI: the first byte after the chip select falls holds read/write in bit 7, auto-increment in bit 6 and the
+// register address in bits 5-0
+class mock_lis3dh_spi : public mock_spi_device {
+public:
+    void select() override { expect_command = true; }
+
+    uint8_t transfer(uint8_t data) override
+    {
+        if (expect_command) {
+            expect_command = false;
+            reading = data & 0x80;
+            sensor.begin_access(data & 0x3F, data & 0x40);
+            return 0xFF;
+        }
+        if (reading) {
+            return sensor.read_next();
+        }
+        sensor.write_next(data);
+        return 0xFF;
+    }
+
+private:
+    bool expect_command = false;
+    bool reading = false;
+};
+
+static mock_lis3dh_i2c i2c_interface;
+static mock_lis3dh_spi spi_interface;
+
+static struct mock_lis3dh_connection {
+    mock_lis3dh_connection()
+    {
+        mock_i2c_attach(ACCEL_I2C_INSTANCE, ACCEL_I2C_ADDRESS, &i2c_interface);
+        mock_spi_attach(ACCEL_SPI_INSTANCE, ACCEL_CS, &spi_interface);
+    }
+} connection;
+
+void mock_lis3dh_set_acceleration(int16_t x, int16_t y, int16_t z)
+{
+    sensor.set_acceleration(x, y, z);
+}
+
+uint8_t mock_lis3dh_get_register(uint8_t reg)
+{
+    return sensor.peek(reg);
+}
+
+void mock_lis3dh_set_connected(bool connected)
+{
+    mock_i2c_attach(ACCEL_I2C_INSTANCE, ACCEL_I2C_ADDRESS, connected ? &i2c_interface : nullptr);
+    mock_spi_attach(ACCEL_SPI_INSTANCE, ACCEL_CS, connected ? &spi_interface : nullptr);
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <stdint.h>
+
+// Test harness: a simulated LIS3DH accelerometer, connected to the I2C bus and address, the SPI bus and chip select,
+// and the INT1 pin given in board.h. Both interfaces reach the same registers, as on the real sensor.
+//
+// It models the register file with auto-increment, sampling at the data rate set in CTRL_REG1, the 32 sample FIFO in
+// bypass, FIFO and stream modes with the wrap from OUT_Z_H back to OUT_X_L, FIFO_SRC, and the watermark and overrun
+// interrupts on INT1. Samples are taken in real time, like the real sensor.
+
+// Test harness: set the acceleration reported by every following sample, as raw left justified values
+void mock_lis3dh_set_acceleration(int16_t x, int16_t y, int16_t z);
+
+// Test harness: read a register without going through the bus or changing the FIFO
+uint8_t mock_lis3dh_get_register(uint8_t reg);
+
+// Test harness: when false the sensor stops acknowledging its I2C address and answering on SPI, as if unplugged
+void mock_lis3dh_set_connected(bool connected);
@@ -0,0 +1,27 @@
+#include <thread>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+
+static std::thread core1;
+static thread_local bool running_on_core1 = false;
+
+void multicore_launch_core1(void (*entry)(void))
+{
+    multicore_reset_core1(); // Only one program can run on core 1 at a time
+    core1 = std::thread([entry] {
+        running_on_core1 = true;
+        entry();
+    });
+}
+
+void multicore_reset_core1()
+{
+    if (core1.joinable()) {
+        core1.join();
+    }
+}
+
+uint get_core_num()
+{
+    return running_on_core1 ? 1 : 0;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+// Second core functionality. Core 1 is emulated with a std::thread.
+void multicore_launch_core1(void (*entry)(void));
+
+// On the real hardware this forcibly resets core 1. A thread cannot be killed, so the mock waits for the entry
+// function to return instead; code must signal core 1 to finish before calling this.
+void multicore_reset_core1();
@@ -1,21 +1,47 @@
 #include <iostream>
+#include <cstdarg>
+#include <cstdlib>
 #include <thread>
 #include <chrono>
+#include <atomic>
 
 #include "pico/stdlib.h"
 #include "ws2812.pio.h"
 
+static std::atomic<bool> sleep_enabled(true);
+
 void stdio_init_all()
 {
 
 }
 
+void panic(const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+    abort();
+}
+
 void sleep_ms(uint32_t ms)
 {
+    if (!sleep_enabled.load()) {
+        return;
+    }
     std::this_thread::sleep_for(std::chrono::milliseconds(ms));
 }
 
 void sleep_us(uint32_t us)
 {
+    if (!sleep_enabled.load()) {
+        return;
+    }
     std::this_thread::sleep_for(std::chrono::microseconds(us));
 }
+
+void mock_set_sleep_enabled(bool enabled)
+{
+    sleep_enabled.store(enabled);
+}
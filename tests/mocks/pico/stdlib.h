@@ -1,8 +1,24 @@
 #pragma once
 #include <stdint.h>
+#include <stddef.h>
+#include "pico/time.h"
 
 // Generic API
+enum pico_error_codes {
+    PICO_OK = 0,
+    PICO_ERROR_GENERIC = -1,
+    PICO_ERROR_TIMEOUT = -2,
+};
 typedef unsigned int uint;
 void stdio_init_all();
 void sleep_ms(uint32_t ms);
 void sleep_us(uint32_t us);
+static inline void tight_loop_contents() {}
+[[noreturn]] void panic(const char *fmt, ...);
+
+// Returns 1 on the thread started by multicore_launch_core1() and 0 on every other thread, including the ones standing
+// in for interrupts. Defined with the multicore mock.
+uint get_core_num();
+
+// Test harness: when false, sleep_ms and sleep_us return immediately so code can run faster than real time
+void mock_set_sleep_enabled(bool enabled);
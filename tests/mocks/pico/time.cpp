@@ -1,4 +1,10 @@
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include "pico/time.h"
+#include "pico/stdlib.h"
 
 absolute_time_t get_absolute_time() 
 {   
@@ -11,3 +17,98 @@ uint32_t to_ms_since_boot(absolute_time_t t)
     auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
     return (uint32_t)millis;
 }
+
+uint64_t time_us_64()
+{
+    auto duration = std::chrono::steady_clock::now().time_since_epoch();
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+uint32_t time_us_32()
+{
+    return (uint32_t)time_us_64();
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past)
+{
+    static std::atomic<alarm_id_t> next_id(1);
+    alarm_id_t id = next_id++;
+    std::thread([=] {
+        // Go through sleep_us so that alarms also fire immediately when the harness disables sleeping
+        sleep_us((uint32_t)us);
+        int64_t reschedule = callback(id, user_data);
+        while (reschedule > 0) {
+            sleep_us((uint32_t)reschedule);
+            reschedule = callback(id, user_data);
+        }
+    }).detach();
+    return id;
+}
+
+// Running repeating timers, so that cancelling one can wait for its thread to let go of the timer
+struct mock_repeating_timer_state {
+    std::atomic<bool> cancelled{false};
+    std::atomic<bool> finished{false};
+    std::thread::id thread;
+};
+static std::mutex mock_repeating_timers_mutex;
+static std::map<alarm_id_t, std::shared_ptr<mock_repeating_timer_state>> mock_repeating_timers;
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data, repeating_timer_t *out)
+{
+    static std::atomic<alarm_id_t> next_id(1);
+    out->delay_us = delay_us;
+    out->alarm_id = next_id++;
+    out->callback = callback;
+    out->user_data = user_data;
+
+    auto state = std::make_shared<mock_repeating_timer_state>();
+    std::lock_guard<std::mutex> guard(mock_repeating_timers_mutex);
+    mock_repeating_timers[out->alarm_id] = state;
+    std::thread worker([=] {
+        // Negative delays are measured between callback starts and positive ones between callbacks, as on the Pico
+        uint32_t period_us = (uint32_t)(delay_us < 0 ? -delay_us : delay_us);
+        auto next = std::chrono::steady_clock::now();
+        for (;;) {
+            if (delay_us < 0) {
+                next += std::chrono::microseconds(period_us);
+                auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(next - std::chrono::steady_clock::now());
+                sleep_us(remaining.count() > 0 ? (uint32_t)remaining.count() : 0);
+            } else {
+                sleep_us(period_us);
+            }
+            if (state->cancelled || !callback(out)) {
+                break;
+            }
+        }
+        state->finished = true;
+    });
+    state->thread = worker.get_id();
+    worker.detach();
+    return true;
+}
+
+bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback, void *user_data, repeating_timer_t *out)
+{
+    return add_repeating_timer_us((int64_t)delay_ms * 1000, callback, user_data, out);
+}
+
+bool cancel_repeating_timer(repeating_timer_t *timer)
+{
+    std::shared_ptr<mock_repeating_timer_state> state;
+    {
+        std::lock_guard<std::mutex> guard(mock_repeating_timers_mutex);
+        auto found = mock_repeating_timers.find(timer->alarm_id);
+        if (found == mock_repeating_timers.end()) {
+            return false;
+        }
+        state = found->second;
+        mock_repeating_timers.erase(found);
+    }
+    state->cancelled = true;
+    // The callback may still be running, as it could be on another core. Wait for it unless cancelling from inside it.
+    while (std::this_thread::get_id() != state->thread && !state->finished) {
+        std::this_thread::yield();
+    }
+    return true;
+}
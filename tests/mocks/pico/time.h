@@ -7,3 +7,23 @@ typedef std::chrono::time_point<std::chrono::steady_clock,std::chrono::steady_cl
 
 uint32_t to_ms_since_boot(absolute_time_t t);
 absolute_time_t get_absolute_time();
+uint64_t time_us_64();
+uint32_t time_us_32();
+
+// Alarms. In the mock each alarm runs its callback on its own thread, standing in for the timer interrupt.
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past);
+
+// Repeating timers. Like alarms, each runs its callback on its own thread.
+typedef struct repeating_timer repeating_timer_t;
+typedef bool (*repeating_timer_callback_t)(repeating_timer_t *rt);
+struct repeating_timer {
+    int64_t delay_us;
+    alarm_id_t alarm_id;
+    repeating_timer_callback_t callback;
+    void *user_data;
+};
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data, repeating_timer_t *out);
+bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback, void *user_data, repeating_timer_t *out);
+bool cancel_repeating_timer(repeating_timer_t *timer);
@@ -9,39 +9,68 @@
 #include "hardware/pio.h"
 #include "ws2812.pio.h"
 
-void ws2812_program_impl(uint32_t data);
+#define MOCK_WS2812_OUTPUTS (NUM_PIOS * NUM_PIO_STATE_MACHINES)
+#define MOCK_WS2812_HISTORY_SIZE 1024
+
+void ws2812_program_impl(PIO pio, unsigned int sm, uint32_t data);
 void ws2812_idle_detection_thread();
 
 pio_program_t ws2812_program = ws2812_program_impl;
 
-// Array in which to receive the LED data during each call to pio_sm_put_blocking
-std::vector<uint32_t> mock_ws2812_leds;
+// One strip of LEDs on the end of a state machine
+struct mock_ws2812_output {
+    unsigned int pin = 0;
+    bool in_use = false;
+    // Array in which to receive the LED data during each call to pio_sm_put_blocking
+    std::vector<uint32_t> leds;
+    // Storage for the last update 
+    std::chrono::steady_clock::time_point last_update;
+    // The most recent words received, kept regardless of latching so tests can inspect the LEDs without relying on
+    // timing
+    uint32_t history[MOCK_WS2812_HISTORY_SIZE];
+    size_t history_count = 0;
+};
+
+static mock_ws2812_output mock_ws2812_outputs[MOCK_WS2812_OUTPUTS];
 std::mutex mock_ws2812_leds_mutex;
 std::binary_semaphore mock_ws2812_semaphore (0); // to signal that the idle detection thread should wake up
-
-// Storage for the last update 
-std::atomic<std::chrono::steady_clock::time_point> last_update;
+static std::atomic<bool> mock_ws2812_verbose(true);
+static std::once_flag mock_ws2812_thread_started;
 
 void ws2812_program_init(PIO pio, unsigned int sm, unsigned int offset, unsigned int pin, float freq, bool rgbw)
 {
-    last_update.store(std::chrono::steady_clock::now());
-    std::thread idle_detection (ws2812_idle_detection_thread);
-    idle_detection.detach();
+    pio_sm_init(pio, sm, offset, nullptr);
+    pio_sm_set_enabled(pio, sm, true);
+
+    {
+        std::lock_guard<std::mutex> guard(mock_ws2812_leds_mutex);
+        mock_ws2812_output &output = mock_ws2812_outputs[pio_get_index(pio) * NUM_PIO_STATE_MACHINES + sm];
+        output.pin = pin;
+        output.in_use = true;
+        output.leds.clear();
+        output.last_update = std::chrono::steady_clock::now();
+    }
+    std::call_once(mock_ws2812_thread_started, [] {
+        std::thread idle_detection (ws2812_idle_detection_thread);
+        idle_detection.detach();
+    });
 }
 
-void ws2812_program_impl(uint32_t data) 
+void ws2812_program_impl(PIO pio, unsigned int sm, uint32_t data) 
 {
     // Store the LED colour we received
     std::lock_guard<std::mutex> guard(mock_ws2812_leds_mutex);
-    mock_ws2812_leds.push_back(data);
+    mock_ws2812_output &output = mock_ws2812_outputs[pio_get_index(pio) * NUM_PIO_STATE_MACHINES + sm];
+    output.leds.push_back(data);
+    output.history[output.history_count++ % MOCK_WS2812_HISTORY_SIZE] = data;
     // Reset the idle detection timer (because the real LEDs wait for the bus to go idle before latching the colours)
-    last_update.store(std::chrono::steady_clock::now());
+    output.last_update = std::chrono::steady_clock::now();
     // Signal to the idle detection thread
     mock_ws2812_semaphore.release();
 }
 
-// Display the LED status 280us after the last message was posted. This emulates the real wire protocol where idle 
-// means to latch the latest values.
+// Display the LED status 280us after the last message was posted to each strip. This emulates the real wire protocol
+// where idle means to latch the latest values.
 void ws2812_idle_detection_thread()
 {
     for (;;) {
@@ -50,28 +79,66 @@ void ws2812_idle_detection_thread()
         std::this_thread::sleep_for(std::chrono::microseconds(280));
         
         for (;;) {
-            // Check that enough time has elapsed
-            auto elapsed = std::chrono::steady_clock::now() - last_update.load();
-            if (elapsed > std::chrono::microseconds(280)) {
+            // Latch every strip that has gone quiet, and stop once none are waiting
+            bool waiting = false;
+            {
                 std::lock_guard<std::mutex> guard(mock_ws2812_leds_mutex);
-                if (mock_ws2812_leds.size() > 0 ) {
-                    printf("Debug: LEDs (R,G,B) = ");
-
-                    for (uint32_t v : mock_ws2812_leds) {
-                        uint8_t r = (0xFF000000 & v) >> 24;
-                        uint8_t g = (0xFF0000 & v) >> 16;
-                        uint8_t b = (0xFF00 & v) >> 8;
-                        printf("(%03u,%03u,%03u),", r, g, b);
+                auto now = std::chrono::steady_clock::now();
+                for (mock_ws2812_output &output : mock_ws2812_outputs) {
+                    if (output.leds.empty()) {
+                        continue;
                     }
-                    printf("\n");
-
-                    mock_ws2812_leds.clear();
-                    break;
+                    if (now - output.last_update <= std::chrono::microseconds(280)) {
+                        waiting = true;
+                        continue;
+                    }
+                    if (mock_ws2812_verbose.load()) {
+                        printf("Debug: LEDs on GPIO %u (R,G,B) = ", output.pin);
+                        for (uint32_t v : output.leds) {
+                            // WS2812 LEDs take green first, then red, then blue
+                            uint8_t g = (0xFF000000 & v) >> 24;
+                            uint8_t r = (0xFF0000 & v) >> 16;
+                            uint8_t b = (0xFF00 & v) >> 8;
+                            printf("(%03u,%03u,%03u),", r, g, b);
+                        }
+                        printf("\n");
+                    }
+                    output.leds.clear();
                 }
             }
+            if (!waiting) {
+                break;
+            }
 
             // Otherwise, wait 10us and try again 
             std::this_thread::sleep_for(std::chrono::microseconds(10));
         }
     }
 }
+
+void mock_ws2812_set_verbose(bool verbose)
+{
+    mock_ws2812_verbose.store(verbose);
+}
+
+size_t mock_ws2812_get_latest(unsigned int pin, uint32_t *words, size_t count)
+{
+    std::lock_guard<std::mutex> guard(mock_ws2812_leds_mutex);
+    for (mock_ws2812_output &output : mock_ws2812_outputs) {
+        if (!output.in_use || output.pin != pin) {
+            continue;
+        }
+        if (count > MOCK_WS2812_HISTORY_SIZE) {
+            count = MOCK_WS2812_HISTORY_SIZE;
+        }
+        if (count > output.history_count) {
+            count = output.history_count;
+        }
+        size_t first = output.history_count - count;
+        for (size_t i = 0; i < count; i++) {
+            words[i] = output.history[(first + i) % MOCK_WS2812_HISTORY_SIZE];
+        }
+        return count;
+    }
+    return 0;
+}
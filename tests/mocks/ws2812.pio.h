@@ -1,7 +1,15 @@
 #pragma once
 #include <stdint.h>
+#include <stddef.h>
 #include "hardware/pio.h"
 
 extern pio_program_t ws2812_program;
 
 void ws2812_program_init(PIO pio, unsigned int sm, unsigned int offset, unsigned int pin, float freq, bool rgbw);
+
+// Test harness: when false the latched LED colours are no longer printed
+void mock_ws2812_set_verbose(bool verbose);
+
+// Test harness: copy the most recent `count` words sent to the LEDs on GPIO `pin` (oldest first) into `words`. Returns
+// how many were copied, which is less than `count` if fewer words have been sent so far.
+size_t mock_ws2812_get_latest(unsigned int pin, uint32_t *words, size_t count);
@@ -0,0 +1,165 @@
+// Replays fast and bouncy press sequences on SW1 and checks that the debounced button sees each press exactly once.
+//
+// Usage: button_replay
+//
+// Each sequence is played twice. First its edges go straight into `button::filter()` with exact timestamps, which
+// checks the debounce logic on its own. Then the same edges drive the mock GPIO pin in real time, so they pass
+// through the interrupt handler and the event queue as on the board, with a consumer thread draining the queue like
+// the main loop. Exits with 1 if any run counts the wrong number of presses.
+
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "board.h"
+#include "drivers/button/button.h"
+#include "utils/event_queue.h"
+
+volatile bool stop_task = false;
+
+#define BOUNCE_EDGE_US 150 // Time between the edges of a bounce, shorter than the debounce window by far
+
+// One press sequence: how long each press is held and the gap after it, with contact bounce on either edge
+struct press_sequence {
+    const char *name;
+    int presses;
+    int hold_us;
+    int gap_us;
+    int bounces; // Extra pairs of edges after each press and each release
+};
+
+static const press_sequence sequences[] = {
+    {"clean presses", 5, 80000, 80000, 0},
+    {"bouncy presses", 5, 80000, 80000, 4},
+    {"fast bouncy presses", 10, 30000, 30000, 3},
+    {"taps shorter than the window", 6, 3000, 40000, 2},
+    {"heavy bounce", 4, 60000, 60000, 10},
+};
+
+// A level on the pin (true for pressed) and how long it lasts
+struct pin_step {
+    bool pressed;
+    int duration_us;
+};
+
+static std::vector<pin_step> build_steps(const press_sequence &sequence)
+{
+    std::vector<pin_step> steps;
+    for (int press = 0; press < sequence.presses; press++) {
+        for (int edge = 0; edge < 2; edge++) {
+            bool pressed = (edge == 0);
+            int settle_us = pressed ? sequence.hold_us : sequence.gap_us;
+            for (int bounce = 0; bounce < sequence.bounces; bounce++) {
+                steps.push_back({pressed, BOUNCE_EDGE_US});
+                steps.push_back({!pressed, BOUNCE_EDGE_US});
+                settle_us -= 2 * BOUNCE_EDGE_US;
+            }
+            steps.push_back({pressed, settle_us});
+        }
+    }
+    return steps;
+}
+
+// Count the presses accepted from one raw edge, or from the settling check
+static void count_change(bool accepted, const event &change, int &presses)
+{
+    if (accepted && change.type == event_type::button_pressed) {
+        presses++;
+    }
+}
+
+// Feed the edges to the debouncer with exact timestamps
+static int replay_timestamps(const std::vector<pin_step> &steps)
+{
+    button sw1; // Never initialised, so it only debounces
+    int presses = 0;
+    uint32_t time_us = 1000000;
+    bool level = false;
+    event change;
+    for (const pin_step &step : steps) {
+        if (step.pressed != level) {
+            level = step.pressed;
+            event edge = {event_type::button_edge, 0, level, time_us};
+            count_change(sw1.filter(edge, change), change, presses);
+        }
+        // The main loop checks for settled changes every few hundred microseconds
+        for (int elapsed = 0; elapsed < step.duration_us; elapsed += 250) {
+            count_change(sw1.update(time_us + elapsed, change), change, presses);
+        }
+        time_us += step.duration_us;
+    }
+    count_change(sw1.update(time_us + BUTTON_DEBOUNCE_US, change), change, presses);
+    return presses;
+}
+
+// Drive the mock pin in real time, with the interrupt handler posting to a queue that another thread drains
+static int replay_pin(const std::vector<pin_step> &steps, uint32_t &dropped, uint32_t &max_latency_us)
+{
+    static event_queue events;
+    static button sw1;
+    static bool initialised = false;
+    if (!initialised) {
+        mock_gpio_set_input(SW1, true); // Released, the pin idles high
+        sw1.init(SW1, events);
+        initialised = true;
+    }
+
+    std::atomic<bool> done(false);
+    std::atomic<int> presses(0);
+    std::thread consumer([&] {
+        event next;
+        event change;
+        for (;;) {
+            bool finished = done; // Read before draining, so nothing posted before the end is missed
+            while (events.poll(next)) {
+                if (sw1.filter(next, change) && change.type == event_type::button_pressed) {
+                    presses++;
+                }
+            }
+            if (sw1.update(event_time_us(), change) && change.type == event_type::button_pressed) {
+                presses++;
+            }
+            if (finished) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+
+    auto next_edge = std::chrono::steady_clock::now();
+    for (const pin_step &step : steps) {
+        mock_gpio_set_input(SW1, !step.pressed);
+        next_edge += std::chrono::microseconds(step.duration_us);
+        std::this_thread::sleep_until(next_edge);
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(2 * BUTTON_DEBOUNCE_US));
+    done = true;
+    consumer.join();
+
+    dropped = events.get_stats().dropped;
+    max_latency_us = events.get_stats().max_latency_us;
+    return presses;
+}
+
+int main()
+{
+    bool all_ok = true;
+    printf("Debounce window %d us, bounce edges every %d us\n", BUTTON_DEBOUNCE_US, BOUNCE_EDGE_US);
+    printf("%-30s %8s %12s %12s %10s\n", "sequence", "presses", "timestamps", "via IRQ", "wait us");
+    for (const press_sequence &sequence : sequences) {
+        std::vector<pin_step> steps = build_steps(sequence);
+        int from_timestamps = replay_timestamps(steps);
+        uint32_t dropped = 0;
+        uint32_t max_latency_us = 0;
+        int from_pin = replay_pin(steps, dropped, max_latency_us);
+        bool ok = from_timestamps == sequence.presses && from_pin == sequence.presses && dropped == 0;
+        all_ok = all_ok && ok;
+        printf("%-30s %8d %12d %12d %10lu (%s)\n", sequence.name, sequence.presses, from_timestamps, from_pin,
+               (unsigned long)max_latency_us, ok ? "ok" : "FAILED");
+    }
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,268 @@
+// Replays recorded (or synthetic) audio through the real microphone task as fast as the host allows, and records or
+// checks the band energies and LED colours of every frame.
+//
+// Usage: replay [options] (<log file> | --synthetic <seconds>)
+//   --column <n>       Take samples from column n (0-based) of comma separated lines. Default 0.
+//   --offset <n>       Add n to every sample, e.g. 2048 for logs that hold samples with the offset already removed.
+//   --synthetic <s>    Use s seconds of a generated log sweep instead of a log file.
+//   --dual-core        Run the capture/analysis pipeline on both mock cores instead of one.
+//   --record <file>    Write the output of every frame to file, to use as a golden output later.
+//   --golden <file>    Compare the output of every frame with file. Exits with 1 on any difference.
+//
+// Lines of the log that are not integers (banners, floats) are skipped, so PuTTY captures can be used as they are.
+//
+// ctest replays 20 s of the synthetic sweep, on one core and on two, and the raw ADC capture src/tasks/putty_mic.log
+// against golden outputs in tests/replay/golden, one set per FFT size. None are committed yet: each replay test fails
+// until its golden is recorded by building the record_goldens target. Build it again after an intended change to the
+// analysis, and commit the goldens with the change. They must come from a build against the real CMSIS-DSP in lib/,
+// as the FFT output is part of them.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmath>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "ws2812.pio.h"
+#include "board.h"
+#include "tasks/microphone_task.h"
+
+volatile bool stop_task = false;
+
+#define MAX_REPORTED_MISMATCHES 10
+
+static std::vector<uint16_t> replay_samples;
+static size_t replay_position = 0; // Only touched by the DMA worker that reads the ADC
+static std::vector<std::string> replay_output;
+
+// Feed the next recorded sample to the ADC. Samples are held back while the task is behind, so neither the capture
+// buffers nor the frame queue overrun and no frame is skipped however slow the analysis is. Past the end of the
+// recording this blocks until the task is stopped.
+static uint16_t replay_next_sample()
+{
+    for (;;) {
+        const microphone_pipeline_stats &stats = get_microphone_pipeline_stats();
+        size_t allowed = SAMPLE_SIZE + (stats.frames_analysed + 1) * HOP_SIZE;
+        size_t capture_limit = (stats.hops_captured + 2) * HOP_SIZE; // Stays within CAPTURE_BUFFER_COUNT - 1 pending
+        allowed = capture_limit < allowed ? capture_limit : allowed;
+        if (stop_task || (replay_position < allowed && replay_position < replay_samples.size())) {
+            break;
+        }
+        std::this_thread::yield();
+    }
+    if (replay_position >= replay_samples.size()) {
+        return 2048;
+    }
+    return replay_samples[replay_position++];
+}
+
+// Record one line per frame: the band energies in Q8.8 dB, then the word sent to each LED
+static void replay_record_frame(const uint16_t (&band_energy_db)[12], const uint8_t (&)[12])
+{
+    uint32_t leds[12] = {0};
+    mock_ws2812_get_latest(LED_PIN, leds, 12);
+
+    char line[256];
+    int length = snprintf(line, sizeof(line), "%zu:", replay_output.size());
+    for (size_t i = 0; i < 12; i++) {
+        length += snprintf(line + length, sizeof(line) - length, " %u", band_energy_db[i]);
+    }
+    length += snprintf(line + length, sizeof(line) - length, " |");
+    for (size_t i = 0; i < 12; i++) {
+        length += snprintf(line + length, sizeof(line) - length, " %08x", leds[i]);
+    }
+    replay_output.push_back(line);
+}
+
+// Parse `text` as a whole integer, allowing surrounding whitespace
+static bool parse_integer(const std::string &text, long &value)
+{
+    const char *start = text.c_str();
+    char *end = nullptr;
+    value = strtol(start, &end, 10);
+    if (end == start) {
+        return false;
+    }
+    while (*end == ' ' || *end == '\t' || *end == '\r') {
+        end++;
+    }
+    return *end == '\0';
+}
+
+static bool load_log(const char *path, size_t column, long offset)
+{
+    std::ifstream file(path);
+    if (!file) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t start = 0;
+        for (size_t i = 0; i < column && start != std::string::npos; i++) {
+            start = line.find(',', start);
+            start = (start == std::string::npos) ? start : start + 1;
+        }
+        if (start == std::string::npos) {
+            continue;
+        }
+        size_t end = line.find(',', start);
+        long value;
+        if (!parse_integer(line.substr(start, end == std::string::npos ? std::string::npos : end - start), value)) {
+            continue;
+        }
+        value += offset;
+        replay_samples.push_back((uint16_t)(value < 0 ? 0 : (value > 4095 ? 4095 : value)));
+    }
+    return true;
+}
+
+// A repeatable test signal: a sine sweeping logarithmically from 50 Hz to 10 kHz, over a little pseudo-random noise
+static void generate_sweep(double seconds)
+{
+    const double start_hz = 50.0;
+    const double end_hz = 10000.0;
+    size_t count = (size_t)(seconds * MICROPHONE_SAMPLE_RATE_HZ);
+    double rate = log(end_hz / start_hz) / seconds;
+    uint32_t noise = 12345;
+    replay_samples.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        double t = i / MICROPHONE_SAMPLE_RATE_HZ;
+        double phase = 2 * M_PI * start_hz * (exp(rate * t) - 1) / rate;
+        noise = noise * 1103515245 + 12345;
+        replay_samples.push_back((uint16_t)(2048 + 1200 * sin(phase) + ((noise >> 16) % 32) - 16));
+    }
+}
+
+// Compare the recorded frames with a golden file, printing the first few differences
+static bool compare_with_golden(const char *path)
+{
+    std::ifstream file(path);
+    if (!file) {
+        fprintf(stderr, "Cannot open %s. Build the record_goldens target to record it.\n", path);
+        return false;
+    }
+    std::vector<std::string> golden;
+    std::string line;
+    while (std::getline(file, line)) {
+        golden.push_back(line);
+    }
+
+    size_t mismatches = 0;
+    size_t common = golden.size() < replay_output.size() ? golden.size() : replay_output.size();
+    for (size_t i = 0; i < common; i++) {
+        if (golden[i] != replay_output[i]) {
+            if (mismatches++ < MAX_REPORTED_MISMATCHES) {
+                printf("Mismatch at line %zu\n  expected %s\n  actual   %s\n", i + 1, golden[i].c_str(), replay_output[i].c_str());
+            }
+        }
+    }
+    if (golden.size() != replay_output.size()) {
+        printf("Expected %zu lines but produced %zu\n", golden.size(), replay_output.size());
+    }
+    printf("%zu of %zu lines differ from %s\n", mismatches, common, path);
+    return mismatches == 0 && golden.size() == replay_output.size();
+}
+
+static void print_usage()
+{
+    fprintf(stderr, "Usage: replay [--column n] [--offset n] [--dual-core] [--record file] [--golden file] "
+                    "(<log file> | --synthetic <seconds>)\n");
+}
+
+int main(int argc, char *argv[])
+{
+    const char *log_path = nullptr;
+    const char *record_path = nullptr;
+    const char *golden_path = nullptr;
+    double synthetic_seconds = 0;
+    size_t column = 0;
+    long offset = 0;
+    bool dual_core = false;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--column") == 0 && has_value) {
+            column = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--offset") == 0 && has_value) {
+            offset = strtol(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--synthetic") == 0 && has_value) {
+            synthetic_seconds = strtod(argv[++i], nullptr);
+        } else if (strcmp(argv[i], "--record") == 0 && has_value) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--golden") == 0 && has_value) {
+            golden_path = argv[++i];
+        } else if (strcmp(argv[i], "--dual-core") == 0) {
+            dual_core = true;
+        } else if (argv[i][0] != '-' && log_path == nullptr) {
+            log_path = argv[i];
+        } else {
+            print_usage();
+            return 2;
+        }
+    }
+
+    if (log_path != nullptr) {
+        if (!load_log(log_path, column, offset)) {
+            return 2;
+        }
+    } else if (synthetic_seconds > 0) {
+        generate_sweep(synthetic_seconds);
+    } else {
+        print_usage();
+        return 2;
+    }
+    if (replay_samples.size() < SAMPLE_SIZE) {
+        fprintf(stderr, "Need at least %d samples for one frame but only found %zu\n", SAMPLE_SIZE, replay_samples.size());
+        return 2;
+    }
+    size_t expected_frames = (replay_samples.size() - SAMPLE_SIZE) / HOP_SIZE + 1;
+
+    // Run flat out: no pacing of the ADC, no LED latch delays and no LED printing
+    mock_adc_set_realtime(false);
+    mock_adc_set_source(replay_next_sample);
+    mock_set_sleep_enabled(false);
+    mock_ws2812_set_verbose(false);
+    set_microphone_frame_observer(replay_record_frame);
+
+    char header[128];
+    snprintf(header, sizeof(header), "# sample_size=%d hop_size=%d bands=12", SAMPLE_SIZE, HOP_SIZE);
+    replay_output.push_back(header);
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread task([dual_core] { run_microphone_task(dual_core); });
+    while (get_microphone_pipeline_stats().frames_analysed < expected_frames) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    stop_task = true;
+    task.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    set_microphone_frame_observer(nullptr);
+
+    // Frames may only be recorded once the task has stopped, so drop any analysed after the end of the recording
+    replay_output.resize(expected_frames + 1);
+
+    const microphone_pipeline_stats &stats = get_microphone_pipeline_stats();
+    double audio_seconds = replay_samples.size() / MICROPHONE_SAMPLE_RATE_HZ;
+    printf("Replayed %zu samples (%.1f s of audio) as %zu frames in %.2f s, %.0fx real time, %u frames skipped\n",
+           replay_samples.size(), audio_seconds, expected_frames, elapsed, audio_seconds / elapsed,
+           (unsigned)stats.frames_skipped);
+
+    if (record_path != nullptr) {
+        std::ofstream file(record_path);
+        for (const std::string &line : replay_output) {
+            file << line << '\n';
+        }
+        printf("Wrote %zu frames to %s\n", expected_frames, record_path);
+    }
+    if (golden_path != nullptr && !compare_with_golden(golden_path)) {
+        return 1;
+    }
+    return 0;
+}
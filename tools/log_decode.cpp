@@ -0,0 +1,120 @@
+// Turns a capture of the board's stdio UART back into text, decoding the frames sent by the deferred logger.
+//
+// Usage: log_decode [capture]
+//
+// Reads the capture from the file given, or from standard input, and writes the text to standard output as it goes.
+// Ordinary text such as printf output passes straight through, so everything the board sent decodes in one go, live
+// from a serial port or from the host harness with `./labs | ./log_decode`. Bytes that look like a frame but fail the
+// checksum are also passed through as text. A summary goes to standard error at the end.
+
+#include <stdio.h>
+#include <string.h>
+#include "drivers/logging/log_messages.h"
+
+#define MAX_CORES 2
+
+// The same names as log() uses
+static const char *level_name(LogLevel level)
+{
+    switch (level) {
+    case LogLevel::INFORMATION:
+        return "Information";
+    case LogLevel::WARNING:
+        return "Warning";
+    case LogLevel::ERROR:
+        return "Error";
+    }
+    return "Unknown";
+}
+
+// Decode the frame at the start of `bytes`, which holds LOG_FRAME_SIZE bytes. Returns false if it is not a frame.
+static bool decode_frame(const uint8_t *bytes, log_record &record)
+{
+    if (bytes[0] != LOG_FRAME_SYNC_0 || bytes[1] != LOG_FRAME_SYNC_1) {
+        return false;
+    }
+    if (log_frame_checksum(bytes + 2, sizeof(record)) != bytes[LOG_FRAME_SIZE - 1]) {
+        return false;
+    }
+    memcpy(&record, bytes + 2, sizeof(record));
+    return record.id < (uint16_t)log_id::count && record.core < MAX_CORES;
+}
+
+// Print a record in the same layout as log(), with microseconds and the core if it is not core 0
+static void print_record(const log_record &record)
+{
+    char message[256];
+    snprintf(message, sizeof(message), log_message_formats[record.id], record.args[0], record.args[1],
+             record.args[2]);
+    printf("[%u.%06u %s]: %s%s\n", record.time_us / 1000000, record.time_us % 1000000,
+           level_name(log_message_levels[record.id]), message, record.core != 0 ? " (core 1)" : "");
+    fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+    FILE *input = stdin;
+    if (argc > 2) {
+        fprintf(stderr, "Usage: %s [capture]\n", argv[0]);
+        return 2;
+    }
+    if (argc == 2) {
+        input = fopen(argv[1], "rb");
+        if (input == nullptr) {
+            fprintf(stderr, "Cannot open %s\n", argv[1]);
+            return 2;
+        }
+    }
+
+    // Slide a frame-sized window over the input: either it holds a whole frame, or its first byte is text
+    uint8_t window[LOG_FRAME_SIZE];
+    size_t length = 0;
+    size_t records = 0;
+    size_t bad_frames = 0;
+    size_t lost = 0;
+    int next_sequence[MAX_CORES] = {-1, -1};
+    bool at_end = false;
+    while (!at_end || length > 0) {
+        while (!at_end && length < LOG_FRAME_SIZE) {
+            int c = fgetc(input);
+            if (c == EOF) {
+                at_end = true;
+                break;
+            }
+            window[length++] = (uint8_t)c;
+        }
+        if (length == 0) {
+            break;
+        }
+
+        log_record record;
+        if (length == LOG_FRAME_SIZE && decode_frame(window, record)) {
+            // Reports of dropped records are made up by the drain and do not take a sequence number
+            if (record.id != (uint16_t)log_id::log_records_dropped) {
+                if (next_sequence[record.core] >= 0) {
+                    lost += (uint8_t)(record.sequence - next_sequence[record.core]);
+                }
+                next_sequence[record.core] = (uint8_t)(record.sequence + 1);
+            }
+            print_record(record);
+            records++;
+            length = 0;
+            continue;
+        }
+        if (length >= 2 && window[0] == LOG_FRAME_SYNC_0 && window[1] == LOG_FRAME_SYNC_1) {
+            bad_frames++;
+        }
+        putchar(window[0]);
+        if (window[0] == '\n') {
+            fflush(stdout);
+        }
+        memmove(window, window + 1, --length);
+    }
+
+    fprintf(stderr, "%zu records decoded, %zu bad frames, %zu records lost in transmission\n", records, bad_frames,
+            lost);
+    if (input != stdin) {
+        fclose(input);
+    }
+    return 0;
+}